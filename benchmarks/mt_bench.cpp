@@ -0,0 +1,351 @@
+#define JDBG_LOG_FUNCTION(str) sink_write(str)
+#define JDBG_IS_OUTPUT_COLOURED (false)
+#define JDBG_IS_OUTPUT_JSON (is_output_json)
+
+#include <string>
+
+namespace {
+
+bool is_output_json = false; // NOLINT
+
+void sink_write(std::string& record);
+
+} // namespace
+
+#include <jdbg/compressed_sink.hpp>
+#include <jdbg/jdbg.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+enum class sink_kind {
+  stderr_stream, // default JDBG_LOG_FUNCTION, std::cerr redirected to a file
+  fd,            // one writev(2) per record straight to a file descriptor
+  json,          // JSON Lines records through std::cerr
+  lz,            // jdbg::compressed_file_sink
+};
+
+struct sink_info {
+  sink_kind kind;
+  const char* name;
+};
+
+constexpr sink_info sinks[] = {
+    {sink_kind::stderr_stream, "stderr"},
+    {sink_kind::fd, "fd"},
+    {sink_kind::json, "json"},
+    {sink_kind::lz, "lz"},
+};
+
+sink_kind current_sink = sink_kind::stderr_stream; // NOLINT
+int sink_fd = -1;                                  // NOLINT
+jdbg::compressed_file_sink* lz_sink = nullptr;     // NOLINT
+
+void sink_write(std::string& record)
+{
+  if (current_sink == sink_kind::fd) {
+    char newline = '\n';
+    iovec iov[] = {
+        {record.data(), record.size()},
+        {&newline, 1},
+    };
+    (void)writev(sink_fd, iov, 2);
+    return;
+  }
+  if (current_sink == sink_kind::lz) {
+    lz_sink->write(record);
+    return;
+  }
+  jdbg::detail::log_line(record);
+}
+
+struct options {
+  unsigned max_threads{std::max(1U, std::thread::hardware_concurrency())};
+  std::size_t records{20000};
+  std::optional<sink_kind> sink;
+};
+
+struct result {
+  double seconds{};
+  std::vector<std::uint64_t> latencies; // nanoseconds, sorted
+};
+
+// Every value carries a "@<thread>:<seq>" tag so records can be verified
+std::string make_tag(unsigned thread, std::size_t seq)
+{
+  return "@" + std::to_string(thread) + ":" + std::to_string(seq);
+}
+
+void emit(unsigned thread, std::size_t seq)
+{
+  const auto tag = make_tag(thread, seq);
+  switch (seq % 5) {
+  case 0:
+    dbg(tag);
+    break;
+  case 1:
+    dbg(std::make_pair(tag, static_cast<double>(seq) * 0.5));
+    break;
+  case 2:
+    dbg(std::vector<std::string>{tag, "x", "y"});
+    break;
+  case 3:
+    dbg(std::map<std::string, std::size_t>{{tag, seq}, {"z", thread}});
+    break;
+  default:
+    dbg(std::optional<std::string>{tag});
+    break;
+  }
+}
+
+result run(unsigned threads, std::size_t records)
+{
+  std::vector<std::vector<std::uint64_t>> latencies(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+
+  const auto start = clock_type::now();
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([t, records, &latencies] {
+      auto& lat = latencies[t];
+      lat.reserve(records);
+      for (std::size_t i = 0; i < records; ++i) {
+        const auto before = clock_type::now();
+        emit(t, i);
+        lat.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock_type::now() - before)
+                .count()));
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  result res;
+  res.seconds =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+  for (auto& lat : latencies) {
+    res.latencies.insert(res.latencies.end(), lat.begin(), lat.end());
+  }
+  std::sort(res.latencies.begin(), res.latencies.end());
+  return res;
+}
+
+std::uint64_t percentile(const std::vector<std::uint64_t>& sorted, double p)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto idx = static_cast<std::size_t>(p * (sorted.size() - 1));
+  return sorted[idx];
+}
+
+std::string decompress(const std::string& data)
+{
+  jdbg::compressed_file_reader reader{data};
+  std::string content;
+  std::string block;
+  while (reader.next(block)) {
+    content += block;
+  }
+  return content;
+}
+
+std::string read_file(int fd)
+{
+  std::string content;
+  char buf[65536];
+  lseek(fd, 0, SEEK_SET);
+  for (;;) {
+    const auto n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+      break;
+    }
+    content.append(buf, static_cast<std::size_t>(n));
+  }
+  return content;
+}
+
+// Every line must be a whole record and every record must appear once
+bool verify(const std::string& content, bool json, unsigned threads,
+            std::size_t records)
+{
+  std::vector<std::vector<unsigned char>> seen(
+      threads, std::vector<unsigned char>(records, 0));
+  std::size_t bad = 0;
+  std::size_t duplicated = 0;
+
+  std::string_view rest{content};
+  while (!rest.empty()) {
+    const auto eol = rest.find('\n');
+    const auto line = rest.substr(0, eol);
+    rest = eol == std::string_view::npos ? std::string_view{}
+                                         : rest.substr(eol + 1);
+
+    const bool framed = json ? (line.substr(0, 9) == "{\"file\":\"" &&
+                                line.back() == '}')
+                             : (line.substr(0, 13) == "[mt_bench.cpp" &&
+                                line.back() == ')');
+    const auto tag = line.find("\"@");
+    if (!framed || tag == std::string_view::npos ||
+        line.find("\"@", tag + 1) != std::string_view::npos) {
+      ++bad;
+      continue;
+    }
+
+    unsigned thread = 0;
+    std::size_t seq = 0;
+    if (std::sscanf(line.data() + tag + 2, "%u:%zu", &thread, &seq) != 2 ||
+        thread >= threads || seq >= records) {
+      ++bad;
+      continue;
+    }
+    if (seen[thread][seq]++ != 0) {
+      ++duplicated;
+    }
+  }
+
+  std::size_t lost = 0;
+  for (const auto& per_thread : seen) {
+    lost += static_cast<std::size_t>(
+        std::count(per_thread.begin(), per_thread.end(), 0));
+  }
+
+  if (bad != 0 || duplicated != 0 || lost != 0) {
+    std::cout << "  FAILED: torn " << bad << ", duplicated " << duplicated
+              << ", lost " << lost << '\n';
+    return false;
+  }
+  return true;
+}
+
+bool bench_sink(const sink_info& sink, const options& opts)
+{
+  std::cout << "sink: " << sink.name << '\n'
+            << "  threads   records/s        p50 ns     p90 ns     p99 ns"
+               "   p99.9 ns     max ns\n";
+
+  std::vector<unsigned> thread_counts;
+  for (unsigned threads = 1; threads < opts.max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(opts.max_threads);
+
+  bool ok = true;
+  for (const auto threads : thread_counts) {
+    char path[] = "/tmp/jdbg-mt-bench-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+      std::perror("mkstemp");
+      return false;
+    }
+    std::optional<jdbg::compressed_file_sink> lz;
+    if (sink.kind == sink_kind::lz) {
+      lz.emplace(path);
+      lz_sink = &*lz;
+    }
+    unlink(path);
+
+    current_sink = sink.kind;
+    is_output_json = sink.kind == sink_kind::json;
+    sink_fd = fd;
+    const int saved_stderr = dup(STDERR_FILENO);
+    dup2(fd, STDERR_FILENO);
+
+    const auto res = run(threads, opts.records);
+    if (lz) {
+      lz->flush();
+    }
+
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+
+    const auto total = static_cast<double>(threads * opts.records);
+    std::printf("  %7u %11.0f %13llu %10llu %10llu %10llu %10llu\n", threads,
+                total / res.seconds,
+                static_cast<unsigned long long>(percentile(res.latencies, 0.5)),
+                static_cast<unsigned long long>(percentile(res.latencies, 0.9)),
+                static_cast<unsigned long long>(
+                    percentile(res.latencies, 0.99)),
+                static_cast<unsigned long long>(
+                    percentile(res.latencies, 0.999)),
+                static_cast<unsigned long long>(res.latencies.back()));
+    std::fflush(stdout);
+
+    const auto content = sink.kind == sink_kind::lz
+                             ? decompress(read_file(fd))
+                             : read_file(fd);
+    ok = verify(content, is_output_json, threads, opts.records) && ok;
+    close(fd);
+  }
+  return ok;
+}
+
+void usage(const char* argv0)
+{
+  std::cout << "usage: " << argv0
+            << " [--threads N] [--records N] [--sink stderr|fd|json|lz]"
+               " [--quick]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    if (arg == "--quick") {
+      opts.max_threads = 4;
+      opts.records = 2000;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      opts.max_threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--records" && i + 1 < argc) {
+      opts.records = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--sink" && i + 1 < argc) {
+      const std::string_view name{argv[++i]};
+      for (const auto& sink : sinks) {
+        if (name == sink.name) {
+          opts.sink = sink.kind;
+        }
+      }
+      if (!opts.sink) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  bool ok = true;
+  for (const auto& sink : sinks) {
+    if (!opts.sink || *opts.sink == sink.kind) {
+      ok = bench_sink(sink, opts) && ok;
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
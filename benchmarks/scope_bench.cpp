@@ -0,0 +1,102 @@
+// Cost of a dbg_scope() span, recorded from one or more threads.
+//
+//   jdbg-scope-bench [--threads N] [--spans N] [--quick]
+//
+// The trace is written to a temporary file and discarded.
+
+#include <jdbg/jdbg.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct options {
+  unsigned max_threads{std::max(1U, std::thread::hardware_concurrency())};
+  std::size_t spans{1000000};
+};
+
+// Nested pairs, so half of the spans have a parent
+void record(std::size_t spans)
+{
+  for (std::size_t i = 0; i < spans; i += 2) {
+    dbg_scope("outer");
+    dbg_scope("inner");
+  }
+}
+
+double run(unsigned threads, std::size_t spans)
+{
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+
+  const auto start = clock_type::now();
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([spans] { record(spans); });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  const auto elapsed = clock_type::now() - start;
+
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                 .count()) /
+         static_cast<double>(spans);
+}
+
+void usage(const char* argv0)
+{
+  std::cout << "usage: " << argv0
+            << " [--threads N] [--spans N] [--quick]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    if (arg == "--quick") {
+      opts.max_threads = 2;
+      opts.spans = 100000;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      opts.max_threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--spans" && i + 1 < argc) {
+      opts.spans = std::max(2, std::atoi(argv[++i]));
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Warm up, also creating the buffer of the main thread
+  record(1000);
+
+  std::cout << "  threads   ns/span (per thread)\n";
+  for (unsigned threads = 1;; threads = std::min(threads * 2,
+                                                 opts.max_threads)) {
+    std::printf("  %7u %10.1f\n", threads, run(threads, opts.spans));
+    if (threads == opts.max_threads) {
+      break;
+    }
+  }
+
+  char path[] = "/tmp/jdbg-scope-bench-XXXXXX";
+  close(mkstemp(path));
+  const int error = jdbg::write_trace(path);
+  unlink(path);
+  return error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,125 @@
+// Reports how much machine code dbg() call sites add to a translation unit.
+//
+//   jdbg-size-bench <variant> <sites-0> <sites-8> <sites-64> [<variant> ...]
+//
+// Each file is an object file or static library built from size_sites.cpp
+// with 0, 8 and 64 call sites over 8 value types. The first 8 sites also
+// instantiate the per-type code, the remaining 56 only add call sites.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <elf.h>
+
+namespace {
+
+// Bytes in executable sections of a relocatable ELF64 object, inline
+// functions included as each of them gets its own .text.* section
+std::optional<std::size_t> elf_text_size(std::string_view obj)
+{
+  Elf64_Ehdr ehdr;
+  if (obj.size() < sizeof(ehdr) ||
+      std::memcmp(obj.data(), ELFMAG, SELFMAG) != 0 ||
+      obj[EI_CLASS] != ELFCLASS64) {
+    return std::nullopt;
+  }
+  std::memcpy(&ehdr, obj.data(), sizeof(ehdr));
+
+  std::size_t size = 0;
+  for (std::size_t i = 0; i < ehdr.e_shnum; ++i) {
+    Elf64_Shdr shdr;
+    const auto offset = ehdr.e_shoff + i * ehdr.e_shentsize;
+    if (offset + sizeof(shdr) > obj.size()) {
+      return std::nullopt;
+    }
+    std::memcpy(&shdr, obj.data() + offset, sizeof(shdr));
+    if (shdr.sh_type == SHT_PROGBITS && (shdr.sh_flags & SHF_EXECINSTR) != 0) {
+      size += shdr.sh_size;
+    }
+  }
+  return size;
+}
+
+// Sums the members of an ar(1) archive, or the file itself if it is none
+std::optional<std::size_t> text_size(std::string_view data)
+{
+  constexpr std::string_view ar_magic{"!<arch>\n"};
+  constexpr std::size_t ar_header_size = 60;
+
+  if (data.substr(0, ar_magic.size()) != ar_magic) {
+    return elf_text_size(data);
+  }
+
+  std::size_t size = 0;
+  std::size_t pos = ar_magic.size();
+  while (pos + ar_header_size <= data.size()) {
+    const auto header = data.substr(pos, ar_header_size);
+    const auto member_size = static_cast<std::size_t>(
+        std::strtoull(std::string{header.substr(48, 10)}.c_str(), nullptr, 10));
+    pos += ar_header_size;
+    if (member_size > data.size() - pos) {
+      return std::nullopt;
+    }
+
+    // The symbol table and long name members are no ELF objects
+    const auto member_text = elf_text_size(data.substr(pos, member_size));
+    if (member_text) {
+      size += *member_text;
+    }
+    pos += member_size + (member_size % 2);
+  }
+  return size;
+}
+
+std::optional<std::size_t> file_text_size(const char* path)
+{
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    return std::nullopt;
+  }
+  const std::string data{std::istreambuf_iterator<char>{file},
+                         std::istreambuf_iterator<char>{}};
+  return text_size(data);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 5 || (argc - 1) % 4 != 0) {
+    std::fprintf(stderr,
+                 "usage: %s <variant> <sites-0> <sites-8> <sites-64> "
+                 "[<variant> ...]\n",
+                 argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::printf("variant          TU .text   8 sites .text  64 sites .text"
+              "   B/first site   B/extra site\n");
+  for (int i = 1; i < argc; i += 4) {
+    std::size_t sizes[3];
+    for (int j = 0; j < 3; ++j) {
+      const auto size = file_text_size(argv[i + 1 + j]);
+      if (!size) {
+        std::fprintf(stderr, "%s: not an ELF64 object or archive\n",
+                     argv[i + 1 + j]);
+        return EXIT_FAILURE;
+      }
+      sizes[j] = *size;
+    }
+
+    const auto first = static_cast<double>(sizes[1]) - sizes[0];
+    const auto extra = static_cast<double>(sizes[2]) - sizes[1];
+    std::printf("%-14s %10zu %15zu %15zu %14.0f %14.0f\n", argv[i], sizes[0],
+                sizes[1], sizes[2], first / 8, extra / 56);
+  }
+  return EXIT_SUCCESS;
+}
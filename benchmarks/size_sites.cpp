@@ -0,0 +1,54 @@
+// dbg() call sites for the code size benchmark. It is compiled with
+// JDBG_SIZE_REPEAT set to 0, 1 and 8, giving 0, 8 and 64 call sites over
+// the same 8 value types.
+#define JDBG_IS_OUTPUT_COLOURED (false)
+
+#include <jdbg/jdbg.hpp>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef JDBG_SIZE_REPEAT
+#define JDBG_SIZE_REPEAT 1
+#endif
+
+struct size_values {
+  int i;
+  double d;
+  const char* c;
+  std::string s;
+  std::vector<int> v;
+  std::map<std::string, int> m;
+  std::optional<long> o;
+  std::pair<int, std::string> p;
+};
+
+#define JDBG_SIZE_SITES(vals)                                                  \
+  dbg(vals.i);                                                                 \
+  dbg(vals.d);                                                                 \
+  dbg(vals.c);                                                                 \
+  dbg(vals.s);                                                                 \
+  dbg(vals.v);                                                                 \
+  dbg(vals.m);                                                                 \
+  dbg(vals.o);                                                                 \
+  dbg(vals.p)
+
+void size_sites(size_values& vals)
+{
+#if JDBG_SIZE_REPEAT >= 1
+  JDBG_SIZE_SITES(vals);
+#endif
+#if JDBG_SIZE_REPEAT >= 8
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+  JDBG_SIZE_SITES(vals);
+#endif
+  (void)vals;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace jdbg {
+
+// Health of a hash table, read through the standard bucket interface
+struct bucket_stats {
+  static constexpr std::size_t histogram_size = 9;
+
+  std::size_t size{0};
+  std::size_t bucket_count{0};
+  double load_factor{0};
+  double max_load_factor{0};
+  std::size_t empty_buckets{0};
+  std::size_t longest_chain{0};
+  // Buckets holding 0, 1, ... 7 elements, the last one 8 or more
+  std::size_t chains[histogram_size]{};
+  // Mean chain length seen by an element relative to a uniform hash: 1 is
+  // as good as random, larger values mean elements pile up in few buckets
+  double clustering{0};
+
+  bool is_poor_hash() const
+  {
+    return size >= min_size_to_judge && clustering > max_clustering;
+  }
+
+  static constexpr std::size_t min_size_to_judge = 32;
+  static constexpr double max_clustering = 2.0;
+};
+
+namespace detail {
+
+template <typename T>
+using bucket_interface_t =
+    decltype(std::declval<const T&>().bucket_count(),
+             std::declval<const T&>().bucket_size(std::size_t{}),
+             std::declval<const T&>().load_factor(),
+             std::declval<const T&>().max_load_factor());
+
+} // namespace detail
+
+// Visits every bucket, which costs O(bucket count + size)
+template <typename Unordered>
+bucket_stats analyze_buckets(const Unordered& val)
+{
+  static_assert(detail::is_detected<detail::bucket_interface_t,
+                                    Unordered>::value,
+                "analyze_buckets() needs an unordered container");
+
+  bucket_stats res;
+  res.size = val.size();
+  res.bucket_count = val.bucket_count();
+  res.load_factor = static_cast<double>(val.load_factor());
+  res.max_load_factor = static_cast<double>(val.max_load_factor());
+
+  // Sum of squared chain lengths, each element sees the chain it is in
+  double squares = 0;
+  for (std::size_t i = 0; i < res.bucket_count; ++i) {
+    const auto chain = static_cast<std::size_t>(val.bucket_size(i));
+    res.longest_chain = std::max(res.longest_chain, chain);
+    ++res.chains[std::min(chain, bucket_stats::histogram_size - 1)];
+    squares += static_cast<double>(chain) * static_cast<double>(chain);
+  }
+  res.empty_buckets = res.chains[0];
+
+  // With a uniform hash an element shares its bucket with (n - 1) / m
+  // others on average
+  if (res.size > 0 && res.bucket_count > 0) {
+    const auto n = static_cast<double>(res.size);
+    const auto expected =
+        1 + (n - 1) / static_cast<double>(res.bucket_count);
+    res.clustering = squares / n / expected;
+  }
+  return res;
+}
+
+inline void pretty_print(ostream& os, const bucket_stats& val)
+{
+  os << "{size: " << val.size << ", buckets: " << val.bucket_count
+     << ", load factor: ";
+  pretty_print(os, val.load_factor);
+  os << ", max load factor: ";
+  pretty_print(os, val.max_load_factor);
+  os << ", empty: " << val.empty_buckets
+     << ", longest chain: " << val.longest_chain << ", chains: {";
+  const char* separator = "";
+  for (std::size_t i = 0; i < bucket_stats::histogram_size; ++i) {
+    if (val.chains[i] != 0) {
+      os << separator << i
+         << (i + 1 == bucket_stats::histogram_size ? "+: " : ": ")
+         << val.chains[i];
+      separator = ", ";
+    }
+  }
+  os << "}, clustering: ";
+  pretty_print(os, val.clustering);
+  if (val.is_poor_hash()) {
+    os << ", warning: poor hash, elements share buckets far more often "
+          "than with a uniform hash";
+  }
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const bucket_stats& val)
+{
+  json.begin_object();
+  json.key("size");
+  json.number(val.size);
+  json.key("bucket_count");
+  json.number(val.bucket_count);
+  json.key("load_factor");
+  json.number(val.load_factor);
+  json.key("max_load_factor");
+  json.number(val.max_load_factor);
+  json.key("empty_buckets");
+  json.number(val.empty_buckets);
+  json.key("longest_chain");
+  json.number(val.longest_chain);
+  json.key("chains");
+  json.begin_array();
+  for (const auto count : val.chains) {
+    json.number(count);
+  }
+  json.end_array();
+  json.key("clustering");
+  json.number(val.clustering);
+  json.key("poor_hash");
+  json.boolean(val.is_poor_hash());
+  json.end_object();
+}
+
+} // namespace jdbg
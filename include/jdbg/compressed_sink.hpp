@@ -0,0 +1,326 @@
+#pragma once
+
+#include <jdbg/detail/flush_hooks.hpp>
+#include <jdbg/detail/hash.hpp>
+#include <jdbg/detail/lz.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Log sink writing LZ compressed blocks of records to a file, e.g.
+//
+//   jdbg::compressed_file_sink jdbg_sink{"trace.jdbg"};
+//   #define JDBG_LOG_FUNCTION(str) jdbg_sink.write(str)
+//   #include <jdbg/jdbg.hpp>
+//
+// The file starts with the 8 byte magic "JDBGLZ1\n", followed by blocks of
+//   raw size (u32 LE), stored size (u32 LE), checksum (u32 LE), data
+// where data is stored uncompressed when compression would not shrink it.
+// Each block is independent, so a file cut short by a crash still decodes
+// up to its last complete block. Use "jdbg-tool decompress" to read it.
+//
+// Blocks are compressed and written by a thread of the sink, so callers of
+// write() only copy their record. A block is handed over once it is full,
+// holds max_records records or its first record is max_delay old, and on
+// flush(), jdbg::flush() and destruction. A crash therefore loses the
+// records of the open block, at most max_records of them and none older
+// than max_delay (100 ms by default), plus up to max_pending blocks queued
+// when the thread falls behind. Records reach the file through write(2),
+// so they survive a crash of the process though not of the machine.
+
+namespace jdbg {
+namespace detail::lz_file {
+
+constexpr std::string_view magic{"JDBGLZ1\n"};
+constexpr std::size_t block_header_size = 12;
+constexpr std::size_t max_block_size = 64 * 1024;
+
+inline void put32(std::string& out, std::uint32_t val)
+{
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((val >> (8 * i)) & 0xFF));
+  }
+}
+
+inline std::uint32_t get32(const char* ptr)
+{
+  std::uint32_t val = 0;
+  for (int i = 3; i >= 0; --i) {
+    val = (val << 8) | static_cast<unsigned char>(ptr[i]);
+  }
+  return val;
+}
+
+inline std::uint32_t checksum(const char* data, std::size_t size)
+{
+  return static_cast<std::uint32_t>(hash_bytes(data, size));
+}
+
+inline bool write_all(int fd, const char* data, std::size_t size)
+{
+  while (size > 0) {
+    const auto written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+} // namespace detail::lz_file
+
+class compressed_file_sink {
+public:
+  static constexpr std::size_t max_pending = 4;
+
+  explicit compressed_file_sink(
+      const char* path,
+      std::size_t block_size = detail::lz_file::max_block_size,
+      std::size_t max_records = 256,
+      std::chrono::milliseconds max_delay = std::chrono::milliseconds{100})
+      : fd_{::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)},
+        block_size_{block_size < detail::lz_file::max_block_size
+                        ? block_size
+                        : detail::lz_file::max_block_size},
+        max_records_{max_records}, max_delay_{max_delay}
+  {
+    block_.reserve(block_size_);
+    if (fd_ >= 0) {
+      detail::lz_file::write_all(fd_, detail::lz_file::magic.data(),
+                                 detail::lz_file::magic.size());
+    }
+    worker_ = std::thread{[this] { run(); }};
+    detail::flush_hooks::instance().add(this, [](void* sink) {
+      static_cast<compressed_file_sink*>(sink)->flush();
+    });
+  }
+
+  ~compressed_file_sink()
+  {
+    detail::flush_hooks::instance().remove(this);
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  compressed_file_sink(const compressed_file_sink&) = delete;
+  compressed_file_sink& operator=(const compressed_file_sink&) = delete;
+
+  bool is_open() const { return fd_ >= 0; }
+
+  // Records longer than a block are split across several blocks
+  void write(std::string_view record)
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (block_.empty()) {
+      opened_ = clock::now();
+      // Starts the timer of the worker
+      wake_.notify_one();
+    }
+    while (!record.empty()) {
+      const auto chunk = record.substr(0, block_size_ - block_.size());
+      block_.append(chunk);
+      record.remove_prefix(chunk.size());
+      if (block_.size() == block_size_) {
+        hand_over(lock);
+      }
+    }
+    block_.push_back('\n');
+    ++records_;
+    if (block_.size() == block_size_ || records_ >= max_records_) {
+      hand_over(lock);
+    }
+  }
+
+  // Returns once every record written so far is in the file
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (!block_.empty()) {
+      hand_over(lock);
+    }
+    written_.wait(lock, [this] { return pending_.empty() && !writing_; });
+  }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  // Queues the open block for the worker, waiting while too many are queued
+  void hand_over(std::unique_lock<std::mutex>& lock)
+  {
+    written_.wait(lock, [this] { return pending_.size() < max_pending; });
+    pending_.push_back(std::move(block_));
+    block_.clear();
+    block_.reserve(block_size_);
+    records_ = 0;
+    wake_.notify_one();
+  }
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      if (!pending_.empty()) {
+        auto block = std::move(pending_.front());
+        pending_.pop_front();
+        writing_ = true;
+        lock.unlock();
+        write_block(block);
+        lock.lock();
+        writing_ = false;
+        written_.notify_all();
+      } else if (!block_.empty() &&
+                 (stopping_ || clock::now() >= opened_ + max_delay_)) {
+        pending_.push_back(std::move(block_));
+        block_.clear();
+        records_ = 0;
+      } else if (stopping_) {
+        return;
+      } else if (!block_.empty()) {
+        wake_.wait_until(lock, opened_ + max_delay_);
+      } else {
+        wake_.wait(lock);
+      }
+    }
+  }
+
+  void write_block(const std::string& block)
+  {
+    using namespace detail::lz_file;
+
+    frame_.clear();
+    put32(frame_, static_cast<std::uint32_t>(block.size()));
+    put32(frame_, 0);
+    put32(frame_, checksum(block.data(), block.size()));
+    detail::lz::compress(block.data(), block.size(), frame_);
+
+    auto stored = frame_.size() - block_header_size;
+    if (stored >= block.size()) {
+      frame_.resize(block_header_size);
+      frame_.append(block);
+      stored = block.size();
+    }
+    for (std::size_t i = 0; i < 4; ++i) {
+      frame_[4 + i] = static_cast<char>((stored >> (8 * i)) & 0xFF);
+    }
+
+    if (fd_ >= 0) {
+      write_all(fd_, frame_.data(), frame_.size());
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable wake_;    // work for the worker
+  std::condition_variable written_; // a queued block was written
+  int fd_;
+  std::size_t block_size_;
+  std::size_t max_records_;
+  std::chrono::milliseconds max_delay_;
+  std::string block_;
+  std::size_t records_{0};
+  clock::time_point opened_;
+  std::deque<std::string> pending_;
+  bool writing_{false};
+  bool stopping_{false};
+  std::string frame_; // only used by the worker
+  std::thread worker_;
+};
+
+// Reads back the blocks written by compressed_file_sink
+class compressed_file_reader {
+public:
+  enum class status { ok, end, truncated, corrupt };
+
+  explicit compressed_file_reader(std::string_view data) : data_{data}
+  {
+    if (data_.substr(0, detail::lz_file::magic.size()) !=
+        detail::lz_file::magic) {
+      status_ = data_.size() < detail::lz_file::magic.size() &&
+                        detail::lz_file::magic.substr(0, data_.size()) == data_
+                    ? status::truncated
+                    : status::corrupt;
+      return;
+    }
+    data_.remove_prefix(detail::lz_file::magic.size());
+  }
+
+  // Replaces out with the next block, false once there is none left
+  bool next(std::string& out)
+  {
+    using namespace detail::lz_file;
+
+    if (status_ != status::ok) {
+      return false;
+    }
+    if (data_.empty()) {
+      status_ = status::end;
+      return false;
+    }
+    if (data_.size() < block_header_size) {
+      status_ = status::truncated;
+      return false;
+    }
+
+    const auto raw_size = get32(data_.data());
+    const auto stored_size = get32(data_.data() + 4);
+    const auto sum = get32(data_.data() + 8);
+    if (raw_size > max_block_size || stored_size > raw_size ||
+        (stored_size == 0 && raw_size != 0)) {
+      status_ = status::corrupt;
+      return false;
+    }
+    if (data_.size() - block_header_size < stored_size) {
+      status_ = status::truncated;
+      return false;
+    }
+
+    const auto* stored = data_.data() + block_header_size;
+    out.resize(raw_size);
+    if (stored_size == raw_size) {
+      out.assign(stored, stored_size);
+    } else if (!detail::lz::decompress(stored, stored_size, out.data(),
+                                       raw_size)) {
+      status_ = status::corrupt;
+      return false;
+    }
+    if (checksum(out.data(), out.size()) != sum) {
+      status_ = status::corrupt;
+      return false;
+    }
+
+    data_.remove_prefix(block_header_size + stored_size);
+    return true;
+  }
+
+  status state() const { return status_; }
+
+private:
+  std::string_view data_;
+  status status_{status::ok};
+};
+
+} // namespace jdbg
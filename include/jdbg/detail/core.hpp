@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// The part of dbg() that does not depend on the type of the value: record
+// header, colouring, JSON framing and handing the record to the sink. Call
+// sites only pass a pointer to their value together with the function that
+// formats it, keeping the code instantiated per type and per site small.
+//
+// Header-only by default. Linking jdbg::core defines JDBG_COMPILED_CORE,
+// which turns these into out-of-line functions compiled once in the library.
+
+#ifdef JDBG_COMPILED_CORE
+#define JDBG_CORE_API
+#else
+#define JDBG_CORE_API inline
+#endif
+
+namespace jdbg::detail {
+
+using sink_fn = void (*)(std::string& record);
+using type_name_fn = const std::string& (*)();
+
+// Appends the value at ptr to out, as JSON when json is set
+using format_fn = void (*)(std::string& out, const void* ptr, bool json);
+
+struct erased_value {
+  const void* ptr;
+  format_fn format;
+};
+
+// Everything known about a dbg() call site before looking at the value
+struct site_info {
+  const char* file;
+  int line;
+  const char* func;
+  const char* expr;
+  bool is_coloured;
+  bool is_json;
+  sink_fn sink;
+};
+
+// Formatters for a std::string_view holding text that is already formatted:
+// format_text quotes it in JSON mode, format_raw never does
+JDBG_CORE_API void format_text(std::string& out, const void* ptr, bool json);
+JDBG_CORE_API void format_raw(std::string& out, const void* ptr, bool json);
+
+JDBG_CORE_API void print_record(const site_info& site, type_name_fn type,
+                                erased_value val,
+                                const char* json_key = "value");
+
+// Value only, for dbg("...") messages
+JDBG_CORE_API void print_message(const site_info& site, erased_value val);
+
+JDBG_CORE_API void print_repeated(const site_info& site, std::size_t count);
+
+} // namespace jdbg::detail
+
+#ifndef JDBG_COMPILED_CORE
+#include <jdbg/detail/core_impl.hpp>
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <jdbg/detail/core.hpp>
+#include <jdbg/detail/thread.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/mem.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace jdbg::detail::core {
+
+constexpr const char* const ansi_empty = "";
+constexpr const char* const ansi_bold = "\x1b[01m";
+constexpr const char* const ansi_faint = "\x1b[02m";
+constexpr const char* const ansi_green = "\x1b[32m";
+constexpr const char* const ansi_cyan = "\x1b[36m";
+constexpr const char* const ansi_reset = "\x1b[0m";
+
+JDBG_CORE_API const char* ansi(const site_info& site, const char* code)
+{
+  return site.is_coloured ? code : ansi_empty;
+}
+
+JDBG_CORE_API const char* file_leaf(const char* file)
+{
+  const char* leaf = std::strrchr(file, '/');
+  return leaf != nullptr ? leaf + 1 : file;
+}
+
+JDBG_CORE_API void print_header(writer& out, const site_info& site)
+{
+  out.write(ansi(site, ansi_faint));
+  out.put('[');
+  out.write(file_leaf(site.file));
+  out.put(':');
+  out.write_integer(site.line);
+  out.write(" (");
+  out.write(site.func);
+  out.write(")] ");
+  out.write(ansi(site, ansi_reset));
+}
+
+JDBG_CORE_API void print_expr(writer& out, const site_info& site)
+{
+  out.write(ansi(site, ansi_cyan));
+  out.write(site.expr);
+  out.write(ansi(site, ansi_reset));
+  out.write(": ");
+}
+
+JDBG_CORE_API void print_val(writer& out, const site_info& site,
+                             erased_value val)
+{
+  out.write(ansi(site, ansi_bold));
+  val.format(out.buffer(), val.ptr, false);
+  out.write(ansi(site, ansi_reset));
+}
+
+JDBG_CORE_API void print_type(writer& out, const site_info& site,
+                              type_name_fn type)
+{
+  out.write(" (");
+  out.write(ansi(site, ansi_green));
+  out.write(type());
+  out.write(ansi(site, ansi_reset));
+  out.put(')');
+}
+
+JDBG_CORE_API void print_json_header(json_writer& json, const site_info& site)
+{
+  json.begin_object();
+  json.key("file");
+  json.string(file_leaf(site.file));
+  json.key("line");
+  json.number(site.line);
+  json.key("func");
+  json.string(site.func);
+  json.key("thread");
+  json.number(thread_id());
+  json.key("timestamp");
+  json.number(timestamp());
+}
+
+// The value is formatted straight into the record, the writer appends
+// after it as json_writer::raw() would
+JDBG_CORE_API void print_json_value(json_writer& json, std::string& record,
+                                    const char* key, erased_value val)
+{
+  json.key(key);
+  json.raw({});
+  val.format(record, val.ptr, true);
+}
+
+} // namespace jdbg::detail::core
+
+namespace jdbg::detail {
+
+JDBG_CORE_API void format_text(std::string& out, const void* ptr, bool json)
+{
+  const auto& text = *static_cast<const std::string_view*>(ptr);
+  if (json) {
+    json_writer{out}.string(text);
+  } else {
+    out += text;
+  }
+}
+
+JDBG_CORE_API void format_raw(std::string& out, const void* ptr,
+                              bool /*json*/)
+{
+  out += *static_cast<const std::string_view*>(ptr);
+}
+
+JDBG_CORE_API void print_record(const site_info& site, type_name_fn type,
+                                erased_value val, const char* json_key)
+{
+  const mem::pause no_count;
+  std::string record;
+  if (site.is_json) {
+    json_writer json{record};
+    core::print_json_header(json, site);
+    json.key("expr");
+    json.string(site.expr);
+    json.key("type");
+    json.string(type());
+    core::print_json_value(json, record, json_key, val);
+    json.end_object();
+  } else {
+    writer out{record};
+    core::print_header(out, site);
+    core::print_expr(out, site);
+    core::print_val(out, site, val);
+    core::print_type(out, site, type);
+  }
+  site.sink(record);
+}
+
+JDBG_CORE_API void print_message(const site_info& site, erased_value val)
+{
+  const mem::pause no_count;
+  std::string record;
+  if (site.is_json) {
+    json_writer json{record};
+    core::print_json_header(json, site);
+    core::print_json_value(json, record, "value", val);
+    json.end_object();
+  } else {
+    writer out{record};
+    core::print_header(out, site);
+    core::print_val(out, site, val);
+  }
+  site.sink(record);
+}
+
+JDBG_CORE_API void print_repeated(const site_info& site, std::size_t count)
+{
+  const mem::pause no_count;
+  std::string record;
+  if (site.is_json) {
+    json_writer json{record};
+    core::print_json_header(json, site);
+    json.key("expr");
+    json.string(site.expr);
+    json.key("repeated");
+    json.number(count);
+    json.end_object();
+  } else {
+    writer out{record};
+    core::print_header(out, site);
+    core::print_expr(out, site);
+    out.write("(repeated ");
+    out.write_integer(count);
+    out.write(count == 1 ? " time)" : " times)");
+  }
+  site.sink(record);
+}
+
+} // namespace jdbg::detail
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace jdbg::detail {
+
+// Buffers kept outside of jdbg.hpp, e.g. by log sinks, that jdbg::flush()
+// writes out after the records it flushes itself
+class flush_hooks {
+public:
+  using hook = void (*)(void* obj);
+
+  static flush_hooks& instance()
+  {
+    static flush_hooks hooks;
+    return hooks;
+  }
+
+  void add(void* obj, hook fn)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    hooks_.emplace_back(obj, fn);
+  }
+
+  void remove(void* obj)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    hooks_.erase(std::remove_if(hooks_.begin(), hooks_.end(),
+                                [obj](const auto& entry) {
+                                  return entry.first == obj;
+                                }),
+                 hooks_.end());
+  }
+
+  void run()
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (const auto& [obj, fn] : hooks_) {
+      fn(obj);
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<std::pair<void*, hook>> hooks_;
+};
+
+} // namespace jdbg::detail
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jdbg::detail {
+
+// 64-bit FNV-1a
+inline std::uint64_t hash_bytes(const void* data, std::size_t size,
+                                std::uint64_t seed = 0xcbf29ce484222325ULL)
+{
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  auto hash = seed;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Finaliser of MurmurHash3, a bijection spreading each bit over all bits
+constexpr std::uint64_t mix64(std::uint64_t val)
+{
+  val ^= val >> 33;
+  val *= 0xff51afd7ed558ccdULL;
+  val ^= val >> 33;
+  val *= 0xc4ceb9fe1a85ec53ULL;
+  val ^= val >> 33;
+  return val;
+}
+
+// Order dependent, combine(a, b) != combine(b, a)
+constexpr std::uint64_t combine(std::uint64_t seed, std::uint64_t val)
+{
+  return mix64(seed * 0x9e3779b97f4a7c15ULL + val);
+}
+
+namespace bulk {
+
+constexpr std::size_t lanes = 8;
+constexpr std::size_t stripe = lanes * sizeof(std::uint64_t);
+constexpr std::size_t block_stripes = 16;
+
+// Each stripe of a block uses the keys starting one further, so stripes
+// cannot be swapped without changing the hash
+constexpr std::uint64_t keys[lanes + block_stripes] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL,
+    0x1f67b3b7a4a44072ULL, 0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL,
+    0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL, 0xcb00c391bb52283cULL,
+    0xa32e531b8b65d088ULL, 0x4ef90da297486471ULL, 0xd8acdea946ef1938ULL,
+    0x3f349ce33f76faa8ULL, 0x1d4f0bc7c7bbdcf9ULL, 0x3159b4cd4be0518aULL,
+    0x647378d9c97e9fc8ULL, 0xc3ebd33483acc5eaULL, 0xeb6313faffa081c5ULL,
+    0x49daf0b751dd0d17ULL, 0x9e68d429265516d3ULL, 0xfca1477d58be162bULL,
+    0xce31d07ad1b8f88fULL, 0x280416958f3acb45ULL, 0x7e404bbbcafbd7afULL};
+
+// acc[i] += word + lo32(word ^ key) * hi32(word ^ key), a 32x32->64 bit
+// multiply per lane that maps onto pmuludq and friends
+#if defined(__GNUC__)
+inline void accumulate(std::uint64_t* acc, const unsigned char* data,
+                       const std::uint64_t* key)
+{
+  typedef std::uint64_t vec __attribute__((vector_size(16))); // NOLINT
+  constexpr std::size_t words = sizeof(vec) / sizeof(std::uint64_t);
+  for (std::size_t i = 0; i < lanes; i += words) {
+    vec sum;
+    vec word;
+    vec k;
+    std::memcpy(&sum, acc + i, sizeof(vec));
+    std::memcpy(&word, data + i * sizeof(std::uint64_t), sizeof(vec));
+    std::memcpy(&k, key + i, sizeof(vec));
+    k ^= word;
+    sum += word + (k & 0xffffffffU) * (k >> 32);
+    std::memcpy(acc + i, &sum, sizeof(vec));
+  }
+}
+#else
+inline void accumulate(std::uint64_t* acc, const unsigned char* data,
+                       const std::uint64_t* key)
+{
+  for (std::size_t i = 0; i < lanes; ++i) {
+    std::uint64_t word;
+    std::memcpy(&word, data + i * sizeof(word), sizeof(word));
+    const auto k = word ^ key[i];
+    acc[i] += word + (k & 0xffffffffU) * (k >> 32);
+  }
+}
+#endif
+
+inline void scramble(std::uint64_t* acc)
+{
+  for (std::size_t i = 0; i < lanes; ++i) {
+    acc[i] = (acc[i] ^ (acc[i] >> 47) ^ keys[i]) * 0x9e3779b1U;
+  }
+}
+
+} // namespace bulk
+
+// Hash for large buffers: independent lanes over 64 byte stripes, mixed
+// between blocks of 1 KiB and once more at the end. Words are read in the
+// byte order of the machine, so hashes only match between machines of the
+// same byte order.
+inline std::uint64_t hash_bulk(const void* data, std::size_t size,
+                               std::uint64_t seed = 0)
+{
+  using namespace bulk;
+
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  auto hash = mix64(seed ^ (size * 0x9e3779b97f4a7c15ULL));
+  if (size <= 2 * sizeof(std::uint64_t)) {
+    // Short strings and the like skip setting up the lanes
+    std::uint64_t words[2] = {};
+    if (size != 0) {
+      std::memcpy(words, bytes, size);
+    }
+    return combine(combine(hash, words[0]), words[1]);
+  }
+
+  std::uint64_t acc[lanes];
+  for (std::size_t i = 0; i < lanes; ++i) {
+    acc[i] = keys[i] ^ seed;
+  }
+
+  std::size_t pos = 0;
+  std::size_t index = 0;
+  for (; size - pos >= stripe; pos += stripe) {
+    accumulate(acc, bytes + pos, keys + index);
+    if (++index == block_stripes) {
+      scramble(acc);
+      index = 0;
+    }
+  }
+  if (pos < size) {
+    unsigned char last[stripe] = {};
+    std::memcpy(last, bytes + pos, size - pos);
+    accumulate(acc, last, keys + index);
+  }
+
+  for (const auto lane : acc) {
+    hash = combine(hash, lane);
+  }
+  return hash;
+}
+
+} // namespace jdbg::detail
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace jdbg::detail {
+
+// Writes all of iov, retrying after short writes and EINTR. Returns 0 or the
+// errno of the failed write.
+inline int writev_all(int fd, iovec* iov, int count)
+{
+  while (count > 0) {
+    const auto written = ::writev(fd, iov, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    auto left = static_cast<std::size_t>(written);
+    for (; count > 0 && left >= iov->iov_len; ++iov, --count) {
+      left -= iov->iov_len;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  return 0;
+}
+
+} // namespace jdbg::detail
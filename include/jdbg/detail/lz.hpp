@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace jdbg::detail::lz {
+
+// LZ77 block format in the spirit of LZ4. A block is a sequence of
+//   token, [literal length bytes], literals, offset (u16 LE), [match bytes]
+// where the token holds the literal length in its high nibble and the match
+// length minus min_match in its low one, 15 meaning more length bytes
+// follow (each adding up to 255). The last sequence has literals only.
+// Offsets are 16-bit, so blocks should not be larger than 64 KiB.
+
+constexpr std::size_t min_match = 4;
+constexpr std::size_t max_offset = 0xFFFF;
+constexpr unsigned hash_bits = 12;
+
+constexpr std::size_t compress_bound(std::size_t size)
+{
+  return size + size / 255 + 16;
+}
+
+inline std::uint32_t read32(const unsigned char* ptr)
+{
+  std::uint32_t val;
+  std::memcpy(&val, ptr, sizeof(val));
+  return val;
+}
+
+inline unsigned char* write_length(unsigned char* op, std::size_t len)
+{
+  for (; len >= 255; len -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<unsigned char>(len);
+  return op;
+}
+
+inline unsigned char* write_sequence(unsigned char* op,
+                                     const unsigned char* literals,
+                                     std::size_t literal_len,
+                                     std::size_t match_len, std::size_t offset)
+{
+  const auto match_code = match_len == 0 ? 0 : match_len - min_match;
+  auto* token = op++;
+  *token = static_cast<unsigned char>(
+      ((literal_len < 15 ? literal_len : 15) << 4) |
+      (match_code < 15 ? match_code : 15));
+  if (literal_len >= 15) {
+    op = write_length(op, literal_len - 15);
+  }
+  std::memcpy(op, literals, literal_len);
+  op += literal_len;
+  if (match_len == 0) {
+    return op;
+  }
+  *op++ = static_cast<unsigned char>(offset & 0xFF);
+  *op++ = static_cast<unsigned char>(offset >> 8);
+  if (match_code >= 15) {
+    op = write_length(op, match_code - 15);
+  }
+  return op;
+}
+
+// Appends the compressed form of src to out
+inline void compress(const char* src, std::size_t size, std::string& out)
+{
+  const auto start = out.size();
+  out.resize(start + compress_bound(size));
+
+  const auto* in = reinterpret_cast<const unsigned char*>(src);
+  auto* op = reinterpret_cast<unsigned char*>(&out[start]);
+
+  std::array<std::uint32_t, std::size_t{1} << hash_bits> table{};
+  std::size_t anchor = 0;
+  std::size_t ip = 0;
+  while (ip + min_match <= size) {
+    const auto seq = read32(in + ip);
+    const auto hash = (seq * 2654435761U) >> (32 - hash_bits);
+    const std::size_t cand = table[hash];
+    table[hash] = static_cast<std::uint32_t>(ip);
+
+    if (cand >= ip || ip - cand > max_offset || read32(in + cand) != seq) {
+      // Skip faster through data that does not compress
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+
+    auto len = min_match;
+    while (ip + len < size && in[cand + len] == in[ip + len]) {
+      ++len;
+    }
+    op = write_sequence(op, in + anchor, ip - anchor, len, ip - cand);
+    ip += len;
+    anchor = ip;
+  }
+  op = write_sequence(op, in + anchor, size - anchor, 0, 0);
+
+  out.resize(static_cast<std::size_t>(
+      op - reinterpret_cast<unsigned char*>(&out[0])));
+}
+
+inline bool read_length(const unsigned char*& ip, const unsigned char* end,
+                        std::size_t& len)
+{
+  for (;;) {
+    if (ip == end) {
+      return false;
+    }
+    const auto byte = *ip++;
+    len += byte;
+    if (byte != 255) {
+      return true;
+    }
+  }
+}
+
+// Decompresses exactly size bytes into dst, false if the input is malformed
+inline bool decompress(const char* src, std::size_t src_size, char* dst,
+                       std::size_t size)
+{
+  const auto* ip = reinterpret_cast<const unsigned char*>(src);
+  const auto* const end = ip + src_size;
+  auto* op = reinterpret_cast<unsigned char*>(dst);
+  auto* const out_end = op + size;
+
+  while (ip != end) {
+    const auto token = *ip++;
+
+    std::size_t literal_len = token >> 4;
+    if (literal_len == 15 && !read_length(ip, end, literal_len)) {
+      return false;
+    }
+    if (literal_len > static_cast<std::size_t>(end - ip) ||
+        literal_len > static_cast<std::size_t>(out_end - op)) {
+      return false;
+    }
+    std::memcpy(op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    const std::size_t offset = ip[0] | (std::size_t{ip[1]} << 8);
+    ip += 2;
+    std::size_t match_len = token & 0xF;
+    if (match_len == 15 && !read_length(ip, end, match_len)) {
+      return false;
+    }
+    match_len += min_match;
+    if (offset == 0 ||
+        offset > static_cast<std::size_t>(op - reinterpret_cast<unsigned char*>(
+                                                   dst)) ||
+        match_len > static_cast<std::size_t>(out_end - op)) {
+      return false;
+    }
+    // Byte by byte as the match may overlap the bytes it produces
+    const auto* match = op - offset;
+    for (std::size_t i = 0; i < match_len; ++i) {
+      op[i] = match[i];
+    }
+    op += match_len;
+  }
+  return op == out_end;
+}
+
+} // namespace jdbg::detail::lz
@@ -5,7 +5,9 @@
 #include <iterator>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace jdbg::detail {
 
@@ -64,6 +66,18 @@ struct is_container<std::basic_string<Ch, Tr, Al>> : std::false_type {};
 template <typename Ch, typename Tr>
 struct is_container<std::basic_string_view<Ch, Tr>> : std::false_type {};
 
+template <typename T>
+struct is_pair : std::false_type {};
+
+template <typename T1, typename T2>
+struct is_pair<std::pair<T1, T2>> : std::true_type {};
+
+template <typename T>
+struct is_tuple : std::false_type {};
+
+template <typename... Ts>
+struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+
 template <typename T>
 struct has_ostream_operator : is_detected<ostream_operator_t, T> {};
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+
+#ifndef JDBG_MAX_POINTER_DEPTH
+#define JDBG_MAX_POINTER_DEPTH 16
+#endif
+
+namespace jdbg::detail {
+
+template <typename T>
+inline constexpr char type_key = 0;
+
+// Pointers this thread is currently following, one node per pretty_print
+// frame, so the whole set lives on the stack and lookups stay within the
+// depth limit. Nodes are keyed by type too, as a struct and its first
+// member share their address.
+class pointer_trail {
+public:
+  template <typename P>
+  explicit pointer_trail(const P* ptr)
+      : ptr_{ptr}, type_{&type_key<P>}, prev_{top()},
+        depth_{prev_ == nullptr ? 1 : prev_->depth_ + 1}
+  {
+    top() = this;
+  }
+
+  ~pointer_trail() { top() = prev_; }
+
+  pointer_trail(const pointer_trail&) = delete;
+  pointer_trail& operator=(const pointer_trail&) = delete;
+
+  template <typename P>
+  static bool contains(const P* ptr)
+  {
+    for (const auto* node = top(); node != nullptr; node = node->prev_) {
+      if (node->ptr_ == ptr && node->type_ == &type_key<P>) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool is_too_deep()
+  {
+    return top() != nullptr && top()->depth_ >= max_depth;
+  }
+
+private:
+  static pointer_trail*& top()
+  {
+    thread_local pointer_trail* top = nullptr;
+    return top;
+  }
+
+private:
+  static constexpr std::size_t max_depth = JDBG_MAX_POINTER_DEPTH;
+
+  const void* ptr_;
+  const char* type_;
+  pointer_trail* prev_;
+  std::size_t depth_;
+};
+
+} // namespace jdbg::detail
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/writer.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifndef JDBG_NO_IOSTREAM
+#include <sstream>
+#endif
+
+namespace jdbg::detail {
+
+// Appends everything written through a std::ostream to a string
+class string_streambuf : public std::streambuf {
+public:
+  explicit string_streambuf(std::string& buf) : buf_{buf} {}
+
+protected:
+  int_type overflow(int_type ch) override
+  {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      buf_.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char_type* str, std::streamsize count) override
+  {
+    buf_.append(str, static_cast<std::size_t>(count));
+    return count;
+  }
+
+private:
+  std::string& buf_;
+};
+
+template <typename T>
+constexpr bool is_char_v = std::is_same_v<T, char> ||
+                           std::is_same_v<T, signed char> ||
+                           std::is_same_v<T, unsigned char>;
+
+// Minimal std::ostream replacement used when JDBG_NO_IOSTREAM is defined,
+// formatting the same way a default constructed std::ostream does
+class text_stream {
+public:
+  text_stream() = default;
+  text_stream(const text_stream&) = delete;
+  text_stream& operator=(const text_stream&) = delete;
+
+  text_stream& operator<<(const char* str)
+  {
+    out_.write(str);
+    return *this;
+  }
+
+  text_stream& operator<<(std::string_view str)
+  {
+    out_.write(str);
+    return *this;
+  }
+
+  text_stream& operator<<(const std::string& str)
+  {
+    out_.write(str);
+    return *this;
+  }
+
+  template <typename T>
+  std::enable_if_t<is_char_v<T>, text_stream&> operator<<(T ch)
+  {
+    out_.put(static_cast<char>(ch));
+    return *this;
+  }
+
+  text_stream& operator<<(bool val)
+  {
+    out_.put(val ? '1' : '0');
+    return *this;
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T> && !is_char_v<T> &&
+                       !std::is_same_v<T, bool>,
+                   text_stream&>
+  operator<<(T val)
+  {
+    out_.write_integer(val);
+    return *this;
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_floating_point_v<T>, text_stream&> operator<<(T val)
+  {
+    out_.write_float(val, default_precision);
+    return *this;
+  }
+
+  text_stream& operator<<(const void* ptr)
+  {
+    out_.write_pointer(ptr);
+    return *this;
+  }
+
+  // Only types relying on their own operator<< go through a real std::ostream
+  template <typename T>
+  std::enable_if_t<!std::is_arithmetic_v<T> && !std::is_pointer_v<T> &&
+                       !std::is_convertible_v<const T&, std::string_view> &&
+                       has_ostream_operator<T>::value,
+                   text_stream&>
+  operator<<(const T& val)
+  {
+    string_streambuf buf{buf_};
+    std::ostream os{&buf};
+    os << val;
+    return *this;
+  }
+
+  const std::string& str() const { return buf_; }
+
+private:
+  static constexpr int default_precision = 6;
+
+  std::string buf_;
+  writer out_{buf_};
+};
+
+#ifdef JDBG_NO_IOSTREAM
+using string_ostream = text_stream;
+#else
+using string_ostream = std::ostringstream;
+#endif
+
+} // namespace jdbg::detail
+
+namespace jdbg {
+
+#ifdef JDBG_NO_IOSTREAM
+using ostream = detail::text_stream;
+#else
+using ostream = std::ostream;
+#endif
+
+} // namespace jdbg
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jdbg::detail {
+
+inline std::uint64_t thread_id()
+{
+#if defined(__linux__)
+  thread_local const auto tid = static_cast<std::uint64_t>(syscall(SYS_gettid));
+#else
+  thread_local const auto tid =
+      static_cast<std::uint64_t>(std::hash<std::thread::id>{}(
+          std::this_thread::get_id()));
+#endif
+  return tid;
+}
+
+// Wall-clock time in nanoseconds since the Unix epoch
+inline std::int64_t timestamp()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace jdbg::detail
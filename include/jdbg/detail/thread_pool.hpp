@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jdbg::detail {
+
+// Fixed set of worker threads running tasks in submission order, started on
+// first use and joined at exit
+class thread_pool {
+public:
+  static thread_pool& instance()
+  {
+    static thread_pool pool{std::max(1U, std::thread::hardware_concurrency())};
+    return pool;
+  }
+
+  explicit thread_pool(unsigned threads)
+  {
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+
+  ~thread_pool()
+  {
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  std::size_t size() const { return workers_.size(); }
+
+  void submit(std::function<void()> task)
+  {
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+private:
+  void run()
+  {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_{false};
+  std::vector<std::thread> workers_;
+};
+
+} // namespace jdbg::detail
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace jdbg::detail {
+
+class writer {
+public:
+  explicit writer(std::string& buf) : buf_{buf} {}
+
+  void put(char c) { buf_.push_back(c); }
+
+  void write(std::string_view str) { buf_.append(str); }
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T>, void> write_integer(T val)
+  {
+    char tmp[24];
+    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), val);
+    buf_.append(tmp, res.ptr);
+  }
+
+  // Shortest representation that round-trips
+  template <typename T>
+  std::enable_if_t<std::is_floating_point_v<T>, void> write_float(T val)
+  {
+    char tmp[64];
+    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), val);
+    buf_.append(tmp, res.ptr);
+  }
+
+  // Same output as std::ostream with the given precision (%g)
+  template <typename T>
+  std::enable_if_t<std::is_floating_point_v<T>, void> write_float(T val,
+                                                                  int precision)
+  {
+    char tmp[64];
+    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), val,
+                                   std::chars_format::general, precision);
+    buf_.append(tmp, res.ptr);
+  }
+
+  void write_hex(std::uintmax_t val, std::size_t width = 0)
+  {
+    char tmp[2 * sizeof(std::uintmax_t)];
+    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), val, 16);
+    const auto len = static_cast<std::size_t>(res.ptr - tmp);
+    if (len < width) {
+      buf_.append(width - len, '0');
+    }
+    buf_.append(tmp, res.ptr);
+  }
+
+  void write_pointer(const void* ptr)
+  {
+    write("0x");
+    write_hex(reinterpret_cast<std::uintptr_t>(ptr));
+  }
+
+  std::string& buffer() { return buf_; }
+
+private:
+  std::string& buf_;
+};
+
+} // namespace jdbg::detail
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jdbg {
+namespace detail {
+
+template <typename T>
+using equality_t =
+    decltype(std::declval<const T&>() == std::declval<const T&>());
+
+template <typename T>
+using key_type_t = typename T::key_type;
+
+template <typename T>
+using mapped_type_t = typename T::mapped_type;
+
+template <typename T>
+struct is_map : std::conjunction<is_container<T>, is_detected<key_type_t, T>,
+                                 is_detected<mapped_type_t, T>> {};
+
+template <typename T>
+struct is_set
+    : std::conjunction<is_container<T>, is_detected<key_type_t, T>,
+                       std::negation<is_detected<mapped_type_t, T>>> {};
+
+template <typename T>
+using element_t = std::decay_t<decltype(*std::begin(std::declval<const T&>()))>;
+
+template <typename T, typename = void>
+struct has_arithmetic_elements : std::false_type {};
+
+template <typename T>
+struct has_arithmetic_elements<T, std::void_t<element_t<T>>>
+    : std::is_arithmetic<element_t<T>> {};
+
+template <typename T, typename = void>
+struct has_floating_point_elements : std::false_type {};
+
+template <typename T>
+struct has_floating_point_elements<T, std::void_t<element_t<T>>>
+    : std::is_floating_point<element_t<T>> {};
+
+template <typename T>
+bool equal(const T& lhs, const T& rhs);
+
+template <typename Tuple, std::size_t... Is>
+bool equal_tuple(const Tuple& lhs, const Tuple& rhs,
+                 std::index_sequence<Is...> /*seq*/)
+{
+  return (equal(std::get<Is>(lhs), std::get<Is>(rhs)) && ...);
+}
+
+// Element-wise where possible, as standard containers, pairs and tuples
+// declare operator== even when their elements do not have one. NaN equals
+// NaN, so a value holding one is not reported as changed on every hit.
+template <typename T>
+bool equal(const T& lhs, const T& rhs)
+{
+  if constexpr (std::is_floating_point_v<T>) {
+    return lhs == rhs || (std::isnan(lhs) && std::isnan(rhs));
+  } else if constexpr (has_arithmetic_elements<T>::value &&
+                       !has_floating_point_elements<T>::value &&
+                       !std::is_array_v<T> &&
+                       is_detected<equality_t, T>::value) {
+    return static_cast<bool>(lhs == rhs);
+  } else if constexpr (is_container<T>::value && !is_map<T>::value &&
+                       !is_set<T>::value) {
+    using std::begin;
+    using std::end;
+
+    return detail::size(lhs) == detail::size(rhs) &&
+           std::equal(begin(lhs), end(lhs), begin(rhs),
+                      [](const auto& l, const auto& r) { return equal(l, r); });
+  } else if constexpr (is_pair<T>::value) {
+    return equal(lhs.first, rhs.first) && equal(lhs.second, rhs.second);
+  } else if constexpr (is_tuple<T>::value) {
+    return equal_tuple(lhs, rhs,
+                       std::make_index_sequence<std::tuple_size_v<T>>{});
+  } else if constexpr (is_detected<equality_t, T>::value) {
+    return static_cast<bool>(lhs == rhs);
+  } else {
+    // Without operator== the only notion of equality left is the output
+    string_ostream lhs_os;
+    string_ostream rhs_os;
+    pretty_print(lhs_os, lhs);
+    pretty_print(rhs_os, rhs);
+    return lhs_os.str() == rhs_os.str();
+  }
+}
+
+struct no_label {};
+
+struct index_label {
+  std::size_t index;
+};
+
+struct get_label {
+  std::size_t index;
+};
+
+template <typename Key>
+struct key_label {
+  const Key& key;
+};
+
+template <typename Key>
+key_label(const Key&) -> key_label<Key>;
+
+// Comma separated list of changes, capped like pretty_print caps containers
+class diff_list {
+public:
+  explicit diff_list(ostream& os) : os_{os} {}
+
+  template <typename Label, typename T>
+  void added(const Label& label, const T& val)
+  {
+    if (entry('+')) {
+      print_label(label);
+      pretty_print(os_, val);
+    }
+  }
+
+  template <typename Label, typename T>
+  void removed(const Label& label, const T& val)
+  {
+    if (entry('-')) {
+      print_label(label);
+      pretty_print(os_, val);
+    }
+  }
+
+  template <typename Label, typename T>
+  void changed(const Label& label, const T& prev, const T& cur)
+  {
+    if (entry('~')) {
+      print_label(label);
+      pretty_print(os_, prev);
+      os_ << " -> ";
+      pretty_print(os_, cur);
+    }
+  }
+
+  std::size_t finish()
+  {
+    if (count_ > max_size) {
+      os_ << ", ... changes: " << count_;
+    }
+    if (count_ > 0) {
+      os_ << '}';
+    }
+    return count_;
+  }
+
+private:
+  bool entry(char kind)
+  {
+    if (++count_ > max_size) {
+      return false;
+    }
+    os_ << (count_ == 1 ? "{" : ", ") << kind;
+    return true;
+  }
+
+  void print_label(no_label /*label*/) {}
+
+  void print_label(const char* label) { os_ << label << ": "; }
+
+  void print_label(index_label label) { os_ << '[' << label.index << "]: "; }
+
+  void print_label(get_label label) { os_ << "get<" << label.index << ">: "; }
+
+  template <typename Key>
+  void print_label(const key_label<Key>& label)
+  {
+    pretty_print(os_, label.key);
+    os_ << ": ";
+  }
+
+private:
+  static constexpr std::size_t max_size = 10;
+
+  ostream& os_;
+  std::size_t count_{0};
+};
+
+template <typename Tuple, std::size_t... Is>
+void diff_tuple(diff_list& diff, const Tuple& prev, const Tuple& cur,
+                std::index_sequence<Is...> /*seq*/)
+{
+  using swallow = int[];
+  (void)swallow{0, ((void)(equal(std::get<Is>(prev), std::get<Is>(cur))
+                               ? void()
+                               : diff.changed(get_label{Is}, std::get<Is>(prev),
+                                              std::get<Is>(cur))),
+                    0)...};
+}
+
+// Entry of a map as added or removed, printed under its key
+template <typename It>
+void added_entry(diff_list& diff, It it)
+{
+  if constexpr (is_pair<std::decay_t<decltype(*it)>>::value) {
+    diff.added(key_label{it->first}, it->second);
+  } else {
+    diff.added(no_label{}, *it);
+  }
+}
+
+template <typename It>
+void removed_entry(diff_list& diff, It it)
+{
+  if constexpr (is_pair<std::decay_t<decltype(*it)>>::value) {
+    diff.removed(key_label{it->first}, it->second);
+  } else {
+    diff.removed(no_label{}, *it);
+  }
+}
+
+template <typename T>
+decltype(auto) key_of(const T& entry)
+{
+  if constexpr (is_pair<T>::value) {
+    return (entry.first);
+  } else {
+    return (entry);
+  }
+}
+
+// Pairs up the runs of equal keys of two associative containers, so that
+// multimaps and multisets compare each duplicate with its counterpart and
+// not with the first equal entry. compare() is called on the pairs, the
+// rest of the longer run is added or removed.
+template <typename T, typename Compare>
+void diff_runs(diff_list& diff, const T& prev, const T& cur,
+               Compare&& compare)
+{
+  for (auto it = cur.begin(); it != cur.end();) {
+    const auto cur_run = cur.equal_range(key_of(*it));
+    const auto prev_run = prev.equal_range(key_of(*it));
+    auto cur_it = cur_run.first;
+    auto prev_it = prev_run.first;
+    for (; cur_it != cur_run.second && prev_it != prev_run.second;
+         ++cur_it, ++prev_it) {
+      compare(prev_it, cur_it);
+    }
+    for (; cur_it != cur_run.second; ++cur_it) {
+      added_entry(diff, cur_it);
+    }
+    for (; prev_it != prev_run.second; ++prev_it) {
+      removed_entry(diff, prev_it);
+    }
+    it = cur_run.second;
+  }
+  for (auto it = prev.begin(); it != prev.end(); ++it) {
+    if (cur.find(key_of(*it)) == cur.end()) {
+      removed_entry(diff, it);
+    }
+  }
+}
+
+} // namespace detail
+
+// Prints the differences between two values of the same type and returns
+// their number, for containers and tuples only the changed elements are shown
+template <typename T>
+std::size_t pretty_print_diff(ostream& os, const T& prev, const T& cur)
+{
+  detail::diff_list diff{os};
+
+  if constexpr (detail::is_map<T>::value) {
+    detail::diff_runs(diff, prev, cur, [&](auto prev_it, auto cur_it) {
+      if (!detail::equal(prev_it->second, cur_it->second)) {
+        diff.changed(detail::key_label{cur_it->first}, prev_it->second,
+                     cur_it->second);
+      }
+    });
+  } else if constexpr (detail::is_set<T>::value) {
+    detail::diff_runs(diff, prev, cur, [&](auto prev_it, auto cur_it) {
+      if (!detail::equal(*prev_it, *cur_it)) {
+        diff.removed(detail::no_label{}, *prev_it);
+        diff.added(detail::no_label{}, *cur_it);
+      }
+    });
+  } else if constexpr (detail::is_container<T>::value) {
+    using std::begin;
+    using std::end;
+
+    auto prev_it = begin(prev);
+    auto cur_it = begin(cur);
+    std::size_t index = 0;
+    for (; prev_it != end(prev) && cur_it != end(cur);
+         ++prev_it, ++cur_it, ++index) {
+      if (!detail::equal(*prev_it, *cur_it)) {
+        diff.changed(detail::index_label{index}, *prev_it, *cur_it);
+      }
+    }
+    for (; cur_it != end(cur); ++cur_it, ++index) {
+      diff.added(detail::index_label{index}, *cur_it);
+    }
+    for (; prev_it != end(prev); ++prev_it, ++index) {
+      diff.removed(detail::index_label{index}, *prev_it);
+    }
+  } else if constexpr (detail::is_pair<T>::value) {
+    if (!detail::equal(prev.first, cur.first)) {
+      diff.changed("first", prev.first, cur.first);
+    }
+    if (!detail::equal(prev.second, cur.second)) {
+      diff.changed("second", prev.second, cur.second);
+    }
+  } else if constexpr (detail::is_tuple<T>::value) {
+    detail::diff_tuple(diff, prev, cur,
+                       std::make_index_sequence<std::tuple_size_v<T>>{});
+  } else {
+    if (detail::equal(prev, cur)) {
+      return 0;
+    }
+    pretty_print(os, prev);
+    os << " -> ";
+    pretty_print(os, cur);
+    return 1;
+  }
+
+  return diff.finish();
+}
+
+namespace detail {
+
+// C arrays cannot be copied, they are kept as std::array instead
+template <typename T>
+struct snapshot_type {
+  using type = T;
+};
+
+template <typename T, std::size_t N>
+struct snapshot_type<T[N]> {
+  using type = std::array<typename snapshot_type<T>::type, N>;
+};
+
+template <typename T>
+using snapshot_type_t = typename snapshot_type<T>::type;
+
+template <typename T>
+decltype(auto) as_snapshot(const T& val)
+{
+  if constexpr (std::is_array_v<T>) {
+    snapshot_type_t<T> res;
+    for (std::size_t i = 0; i < std::extent_v<T>; ++i) {
+      res[i] = as_snapshot(val[i]);
+    }
+    return res;
+  } else {
+    return (val);
+  }
+}
+
+// Snapshot of the last value seen at a single dbg_diff() call site
+template <typename T>
+class diff_state {
+public:
+  enum class result { initial, unchanged, changed };
+
+  result update(ostream& os, const T& val)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto& cur = as_snapshot(val);
+    if (!snapshot_.has_value()) {
+      snapshot_.emplace(cur);
+      return result::initial;
+    }
+    if (equal(*snapshot_, cur)) {
+      return result::unchanged;
+    }
+    pretty_print_diff(os, *snapshot_, cur);
+    *snapshot_ = cur;
+    return result::changed;
+  }
+
+private:
+  std::mutex mutex_;
+  std::optional<snapshot_type_t<T>> snapshot_;
+};
+
+} // namespace detail
+} // namespace jdbg
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <jdbg/detail/io.hpp>
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/detail/thread_pool.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace jdbg {
+
+struct dump_result {
+  std::size_t elements{0};
+  std::size_t bytes{0};
+  int error{0}; // errno of the failed open or write, 0 on success
+};
+
+namespace detail::dump {
+
+constexpr std::size_t chunk_elements = 16 * 1024;
+
+// One element per line, formatted like dbg() would without the size limit
+template <typename It>
+void format_chunk(std::string& out, It first, It last, bool json)
+{
+  if (json) {
+    for (; first != last; ++first) {
+      json_writer writer{out};
+      json_print(writer, *first);
+      out += '\n';
+    }
+    return;
+  }
+
+#ifdef JDBG_NO_IOSTREAM
+  text_stream os;
+#else
+  string_streambuf buf{out};
+  std::ostream os{&buf};
+#endif
+  for (; first != last; ++first) {
+    pretty_print(os, *first);
+    os << '\n';
+  }
+#ifdef JDBG_NO_IOSTREAM
+  out += os.str();
+#endif
+}
+
+// Chunks are formatted on the thread pool while the calling thread walks the
+// container to find chunk boundaries, which is free for random access
+// iterators, and writes finished chunks in order. Only a window of chunks is
+// in flight at any time, bounding memory use. An exception while formatting
+// a chunk is rethrown on the calling thread once the chunks before it are
+// written and those in flight are done, as the serial path would throw.
+template <typename It>
+void write_chunks(int fd, It first, std::size_t count, bool json,
+                  dump_result& result)
+{
+  auto& pool = thread_pool::instance();
+  auto chunks = (count + chunk_elements - 1) / chunk_elements;
+  const auto window = std::min<std::size_t>(chunks, 2 * pool.size() + 2);
+
+  std::vector<std::string> bufs(window);
+  std::vector<char> ready(window, 0);
+  std::vector<std::exception_ptr> failures(window);
+  std::exception_ptr failure;
+  std::vector<iovec> iov(window);
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  std::size_t submitted = 0;
+  std::size_t written = 0;
+  while (written < chunks) {
+    for (; submitted < chunks && submitted - written < window; ++submitted) {
+      const auto slot = submitted % window;
+      using diff_t = typename std::iterator_traits<It>::difference_type;
+      const auto size =
+          std::min(chunk_elements, count - submitted * chunk_elements);
+      const auto last = std::next(first, static_cast<diff_t>(size));
+      pool.submit([&, slot, first, last] {
+        try {
+          format_chunk(bufs[slot], first, last, json);
+        } catch (...) {
+          failures[slot] = std::current_exception();
+        }
+        // Notifying under the lock as the writer may return right after
+        const std::lock_guard<std::mutex> lock{mutex};
+        ready[slot] = 1;
+        cv.notify_all();
+      });
+      first = last;
+    }
+
+    std::size_t batch = 0;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      cv.wait(lock, [&] { return ready[written % window] != 0; });
+      while (written + batch < submitted &&
+             ready[(written + batch) % window] != 0) {
+        ++batch;
+      }
+    }
+
+    // Chunks after a failed one are not written
+    std::size_t good = 0;
+    for (; failure == nullptr && good < batch; ++good) {
+      const auto slot = (written + good) % window;
+      if (failures[slot] != nullptr) {
+        failure = failures[slot];
+        // Only wait for the chunks already being formatted
+        chunks = submitted;
+        break;
+      }
+      iov[good] = {bufs[slot].data(), bufs[slot].size()};
+      result.bytes += bufs[slot].size();
+    }
+    if (result.error == 0 && good > 0) {
+      result.error = writev_all(fd, iov.data(), static_cast<int>(good));
+      if (result.error != 0) {
+        chunks = submitted;
+      }
+    }
+
+    const std::lock_guard<std::mutex> lock{mutex};
+    for (std::size_t i = 0; i < batch; ++i) {
+      const auto slot = (written + i) % window;
+      bufs[slot].clear();
+      ready[slot] = 0;
+      failures[slot] = nullptr;
+    }
+    written += batch;
+  }
+
+  if (failure != nullptr) {
+    std::rethrow_exception(failure);
+  }
+}
+
+} // namespace detail::dump
+
+// Writes every element of a container to path, one per line, as text or as
+// JSON Lines. Large containers are formatted in parallel.
+template <typename Container>
+dump_result dump(const char* path, const Container& val, bool json = false)
+{
+  static_assert(detail::is_container<Container>::value,
+                "dump() needs a container");
+
+  dump_result result;
+  const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    result.error = errno;
+    return result;
+  }
+
+  using std::begin;
+  using std::end;
+  result.elements = static_cast<std::size_t>(detail::size(val));
+
+  try {
+    if (result.elements <= detail::dump::chunk_elements) {
+      std::string buf;
+      detail::dump::format_chunk(buf, begin(val), end(val), json);
+      iovec iov{buf.data(), buf.size()};
+      result.bytes = buf.size();
+      result.error = detail::writev_all(fd, &iov, 1);
+    } else {
+      detail::dump::write_chunks(fd, begin(val), result.elements, json,
+                                 result);
+    }
+  } catch (...) {
+    // Formatting an element threw, the file keeps what was written
+    ::close(fd);
+    throw;
+  }
+
+  if (::close(fd) != 0 && result.error == 0) {
+    result.error = errno;
+  }
+  return result;
+}
+
+namespace detail::dump {
+
+// What dbg_dump() prints instead of the value
+inline std::string describe(const dump_result& result, const char* path)
+{
+  std::string text;
+  writer out{text};
+  if (result.error != 0) {
+    out.write("cannot dump to ");
+    out.write(path);
+    out.write(": ");
+    out.write(std::strerror(result.error));
+    return text;
+  }
+  out.write("dumped ");
+  out.write_integer(result.elements);
+  out.write(" elements (");
+  out.write_integer(result.bytes);
+  out.write(" bytes) to ");
+  out.write(path);
+  return text;
+}
+
+} // namespace detail::dump
+
+} // namespace jdbg
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <jdbg/detail/hash.hpp>
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/pointer_trail.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace jdbg {
+
+// A 64-bit hash of a value's structure, printed by dbg_hash() instead of the
+// value. Equal values give equal hashes in every run and build on machines
+// of the same byte order, so state of two runs or replicas can be compared
+// through their fingerprints.
+struct fingerprint {
+  std::uint64_t hash{0};
+  std::size_t elements{0}; // numbers, strings and other leaves hashed
+};
+
+namespace detail::structural {
+
+// Stand-ins for values without a hashable representation
+enum class tag : std::uint64_t {
+  null = 0x6e756c6c,
+  engaged,
+  address,
+  cycle,
+  too_deep,
+  valueless,
+};
+
+template <typename T>
+struct is_string : std::false_type {};
+
+template <typename Ch, typename Tr, typename Al>
+struct is_string<std::basic_string<Ch, Tr, Al>> : std::true_type {};
+
+template <typename Ch, typename Tr>
+struct is_string<std::basic_string_view<Ch, Tr>> : std::true_type {};
+
+template <typename T>
+struct is_smart_pointer : std::false_type {};
+
+template <typename T, typename Deleter>
+struct is_smart_pointer<std::unique_ptr<T, Deleter>> : std::true_type {};
+
+template <typename T>
+struct is_smart_pointer<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_optional : std::false_type {};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_variant : std::false_type {};
+
+template <typename... Ts>
+struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+// Numbers whose object representation is their value, and arrays of them,
+// hashed as raw memory when stored contiguously. long double is left out
+// for its padding.
+template <typename T>
+struct is_bulk
+    : std::bool_constant<std::is_integral_v<T> || std::is_enum_v<T> ||
+                         std::is_same_v<T, float> ||
+                         std::is_same_v<T, double>> {};
+
+template <typename T, std::size_t N>
+struct is_bulk<T[N]> : is_bulk<T> {};
+
+template <typename T, std::size_t N>
+struct is_bulk<std::array<T, N>> : is_bulk<T> {};
+
+template <typename T>
+constexpr std::size_t leaves = 1;
+
+template <typename T, std::size_t N>
+constexpr std::size_t leaves<T[N]> = N * leaves<T>;
+
+template <typename T, std::size_t N>
+constexpr std::size_t leaves<std::array<T, N>> = N * leaves<T>;
+
+template <typename T>
+using key_equal_t = typename T::key_equal;
+
+template <typename T>
+using data_t = decltype(std::data(std::declval<const T&>()));
+
+template <typename T>
+constexpr bool is_char_array = false;
+
+template <std::size_t N>
+constexpr bool is_char_array<char[N]> = true;
+
+// Walks a value like pretty_print does, except that containers are hashed
+// whole, unordered ones independent of their iteration order, and that
+// pointers are followed without hashing the address
+class hasher {
+public:
+  template <typename T>
+  std::uint64_t value(const T& val)
+  {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      ++elements_;
+      return scalar(val);
+    } else if constexpr (is_string<T>::value) {
+      return string(val.data(), val.size());
+    } else if constexpr (is_char_array<T>) {
+      // Printed up to the terminator
+      const auto* end =
+          static_cast<const char*>(std::memchr(val, '\0', sizeof(val)));
+      return string(val, end == nullptr ? sizeof(val)
+                                        : static_cast<std::size_t>(end - val));
+    } else if constexpr (std::is_same_v<T, const char*> ||
+                         std::is_same_v<T, char*>) {
+      if (val == nullptr) {
+        return leaf(tag::null);
+      }
+      return string(val, std::strlen(val));
+    } else if constexpr (std::is_pointer_v<T>) {
+      return pointer(val);
+    } else if constexpr (is_smart_pointer<T>::value) {
+      return pointer(val.get());
+    } else if constexpr (is_pair<T>::value) {
+      return combine(value(val.first), value(val.second));
+    } else if constexpr (is_tuple<T>::value) {
+      auto hash = mix64(std::tuple_size_v<T>);
+      std::apply(
+          [&](const auto&... elems) {
+            static_cast<void>(((hash = combine(hash, value(elems))), ...));
+          },
+          val);
+      return hash;
+    } else if constexpr (is_optional<T>::value) {
+      if (!val.has_value()) {
+        return leaf(tag::null);
+      }
+      return combine(static_cast<std::uint64_t>(tag::engaged), value(*val));
+    } else if constexpr (is_variant<T>::value) {
+      if (val.valueless_by_exception()) {
+        return leaf(tag::valueless);
+      }
+      return combine(val.index(),
+                     std::visit([&](const auto& arg) { return value(arg); },
+                                val));
+    } else if constexpr (is_container<T>::value) {
+      return range(val);
+    } else {
+      return text(val);
+    }
+  }
+
+  std::size_t elements() const { return elements_; }
+
+private:
+  template <typename T>
+  static std::uint64_t scalar(const T& val)
+  {
+    if constexpr (std::is_same_v<T, long double>) {
+      return scalar(static_cast<double>(val));
+    } else if constexpr (sizeof(T) > sizeof(std::uint64_t)) {
+      return hash_bulk(&val, sizeof(val));
+    } else {
+      std::uint64_t bits = 0;
+      std::memcpy(&bits, &val, sizeof(val));
+      return mix64(bits ^ (sizeof(val) << 56));
+    }
+  }
+
+  std::uint64_t leaf(tag val)
+  {
+    ++elements_;
+    return mix64(static_cast<std::uint64_t>(val));
+  }
+
+  template <typename Ch>
+  std::uint64_t string(const Ch* data, std::size_t size)
+  {
+    ++elements_;
+    return hash_bulk(data, size * sizeof(Ch));
+  }
+
+  template <typename P>
+  std::uint64_t pointer(P* val)
+  {
+    if (val == nullptr) {
+      return leaf(tag::null);
+    }
+    if constexpr (std::is_void_v<P> || std::is_function_v<P>) {
+      // Only the address is printed, which differs between runs
+      return leaf(tag::address);
+    } else {
+      if (pointer_trail::contains(val)) {
+        return leaf(tag::cycle);
+      }
+      if (pointer_trail::is_too_deep()) {
+        return leaf(tag::too_deep);
+      }
+      const pointer_trail trail{val};
+      return value(*val);
+    }
+  }
+
+  template <typename Container>
+  std::uint64_t range(const Container& val)
+  {
+    const auto size = static_cast<std::uint64_t>(detail::size(val));
+
+    if constexpr (is_detected<key_equal_t, Container>::value) {
+      // A sum is the same in any order and, unlike xor, does not cancel out
+      // pairs of equal elements
+      std::uint64_t sum = 0;
+      for (const auto& elem : val) {
+        sum += mix64(value(elem));
+      }
+      return combine(mix64(size), sum);
+    } else if constexpr (is_detected<data_t, Container>::value) {
+      using T = std::remove_cv_t<std::remove_pointer_t<data_t<Container>>>;
+      if constexpr (is_bulk<T>::value) {
+        elements_ += size * leaves<T>;
+        return combine(mix64(size),
+                       hash_bulk(std::data(val), size * sizeof(T)));
+      } else {
+        return sequence(val, size);
+      }
+    } else {
+      return sequence(val, size);
+    }
+  }
+
+  template <typename Container>
+  std::uint64_t sequence(const Container& val, std::uint64_t size)
+  {
+    auto hash = mix64(size);
+    for (const auto& elem : val) {
+      hash = combine(hash, value(elem));
+    }
+    return hash;
+  }
+
+  // Anything else is hashed as it prints
+  template <typename T>
+  std::uint64_t text(const T& val)
+  {
+    string_ostream os;
+    pretty_print(os, val);
+    const auto str = os.str();
+    return string(str.data(), str.size());
+  }
+
+private:
+  std::size_t elements_{0};
+};
+
+} // namespace detail::structural
+
+template <typename T>
+fingerprint fingerprint_of(const T& val)
+{
+  detail::structural::hasher hasher;
+  const auto hash = hasher.value(val);
+  return {hash, hasher.elements()};
+}
+
+namespace detail::structural {
+
+inline std::string hex(std::uint64_t hash)
+{
+  std::string str;
+  writer{str}.write_hex(hash, 16);
+  return str;
+}
+
+} // namespace detail::structural
+
+inline void pretty_print(ostream& os, const fingerprint& val)
+{
+  os << "{hash: " << detail::structural::hex(val.hash).c_str()
+     << ", elements: " << val.elements << '}';
+}
+
+// The hash as a string, JSON numbers do not hold 64 bits in every reader
+inline void json_print(json_writer& json, const fingerprint& val)
+{
+  json.begin_object();
+  json.key("hash");
+  json.string(detail::structural::hex(val.hash));
+  json.key("elements");
+  json.number(val.elements);
+  json.end_object();
+}
+
+} // namespace jdbg
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/pointer_trail.hpp>
+#include <jdbg/fingerprint.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace jdbg {
+
+// Heap memory a value owns, estimated from the sizes and capacities of its
+// containers, strings and smart pointers. Node and control block sizes
+// follow libstdc++, the allocator's own bookkeeping is not counted.
+struct footprint {
+  struct level {
+    std::size_t used{0};     // bytes holding elements
+    std::size_t reserved{0}; // bytes allocated
+    std::size_t slack() const { return reserved - used; }
+  };
+
+  std::size_t inline_size{0}; // sizeof the value itself
+  std::size_t used{0};
+  std::size_t reserved{0};
+  // Allocations owned by the value, then those owned by its elements and
+  // so on, spare capacity and node overhead are the slack of each
+  std::vector<level> levels;
+  bool is_partial{false}; // pointers nested too deep were not followed
+
+  std::size_t slack() const { return reserved - used; }
+};
+
+namespace detail::heap {
+
+template <typename T>
+struct is_owned_string : std::false_type {};
+
+template <typename Ch, typename Tr, typename Al>
+struct is_owned_string<std::basic_string<Ch, Tr, Al>> : std::true_type {};
+
+template <typename T>
+struct is_unique_ptr : std::false_type {};
+
+template <typename T, typename Deleter>
+struct is_unique_ptr<std::unique_ptr<T, Deleter>> : std::true_type {};
+
+template <typename T>
+struct is_shared_ptr : std::false_type {};
+
+template <typename T>
+struct is_shared_ptr<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_bit_vector : std::false_type {};
+
+template <typename Al>
+struct is_bit_vector<std::vector<bool, Al>> : std::true_type {};
+
+template <typename T>
+struct is_deque : std::false_type {};
+
+template <typename T, typename Al>
+struct is_deque<std::deque<T, Al>> : std::true_type {};
+
+// Pointers in each node of a list besides the element
+template <typename T>
+constexpr std::size_t list_links = 0;
+
+template <typename T, typename Al>
+constexpr std::size_t list_links<std::list<T, Al>> = 2;
+
+template <typename T, typename Al>
+constexpr std::size_t list_links<std::forward_list<T, Al>> = 1;
+
+template <typename T>
+using capacity_t = decltype(std::declval<const T&>().capacity());
+
+template <typename T>
+using key_compare_t = typename T::key_compare;
+
+template <typename T>
+using hasher_t = typename T::hasher;
+
+template <typename T>
+using tuple_size_t = decltype(std::tuple_size<T>::value);
+
+// Parent, left and right links and the colour of a red-black tree node
+constexpr std::size_t tree_links = 4;
+// Reference counts and vtable of a make_shared control block
+constexpr std::size_t control_block_size = 16;
+// Elements of a deque live in blocks of this many bytes, or one element
+constexpr std::size_t deque_block_size = 512;
+constexpr std::size_t deque_min_map_size = 8;
+
+// Bytes of a node holding a T after the given number of pointers
+template <typename T>
+constexpr std::size_t node_size(std::size_t links)
+{
+  constexpr auto align = std::max(alignof(T), alignof(void*));
+  const auto start =
+      (links * sizeof(void*) + alignof(T) - 1) / alignof(T) * alignof(T);
+  return (start + sizeof(T) + align - 1) / align * align;
+}
+
+// Walks a value like pretty_print does, counting what each container,
+// string and smart pointer has allocated. Elements are visited only when
+// they could own memory themselves.
+class counter {
+public:
+  template <typename T>
+  void value(const T& val, std::size_t depth)
+  {
+    if constexpr (is_owned_string<T>::value) {
+      string(val, depth);
+    } else if constexpr (is_unique_ptr<T>::value) {
+      owned(val.get(), 0, depth);
+    } else if constexpr (is_shared_ptr<T>::value) {
+      // Counted once however many pointers share it
+      if (val != nullptr && shared_.insert(val.get()).second) {
+        owned(val.get(), control_block_size, depth);
+      }
+    } else if constexpr (is_pair<T>::value) {
+      value(val.first, depth);
+      value(val.second, depth);
+    } else if constexpr (is_tuple<T>::value) {
+      std::apply([&](const auto&... elems) { (value(elems, depth), ...); },
+                 val);
+    } else if constexpr (structural::is_optional<T>::value) {
+      if (val.has_value()) {
+        value(*val, depth);
+      }
+    } else if constexpr (structural::is_variant<T>::value) {
+      if (!val.valueless_by_exception()) {
+        std::visit([&](const auto& arg) { value(arg, depth); }, val);
+      }
+    } else if constexpr (std::is_array_v<T> ||
+                         (is_container<T>::value &&
+                          is_detected<tuple_size_t, T>::value)) {
+      // Elements of arrays are part of the value
+      elements(val, depth);
+    } else if constexpr (is_bit_vector<T>::value) {
+      allocate(depth, (val.size() + CHAR_BIT - 1) / CHAR_BIT,
+               (val.capacity() + CHAR_BIT - 1) / CHAR_BIT);
+    } else if constexpr (is_deque<T>::value) {
+      deque(val, depth);
+    } else if constexpr (list_links<T> != 0) {
+      const auto size = static_cast<std::size_t>(
+          std::distance(std::begin(val), std::end(val)));
+      nodes(val, size, list_links<T>, depth);
+    } else if constexpr (is_detected<key_compare_t, T>::value) {
+      nodes(val, val.size(), tree_links, depth);
+    } else if constexpr (is_detected<hasher_t, T>::value) {
+      // The hash of string keys is cached in the node
+      using key_type = typename T::key_type;
+      nodes(val, val.size(), is_owned_string<key_type>::value ? 2 : 1,
+            depth);
+      allocate(depth, 0, val.bucket_count() * sizeof(void*));
+    } else if constexpr (is_container<T>::value &&
+                         is_detected<capacity_t, T>::value) {
+      using elem_type = typename T::value_type;
+      allocate(depth, val.size() * sizeof(elem_type),
+               val.capacity() * sizeof(elem_type));
+      elements(val, depth + 1);
+    }
+    // Anything else, including views and raw pointers, owns nothing
+  }
+
+  footprint result() const
+  {
+    footprint res;
+    res.levels = levels_;
+    for (const auto& level : levels_) {
+      res.used += level.used;
+      res.reserved += level.reserved;
+    }
+    res.is_partial = is_partial_;
+    return res;
+  }
+
+private:
+  void allocate(std::size_t depth, std::size_t used, std::size_t reserved)
+  {
+    if (reserved == 0) {
+      return;
+    }
+    if (levels_.size() <= depth) {
+      levels_.resize(depth + 1);
+    }
+    levels_[depth].used += used;
+    levels_[depth].reserved += reserved;
+  }
+
+  template <typename Container>
+  void elements(const Container& val, std::size_t depth)
+  {
+    using elem_type = std::remove_cv_t<
+        std::remove_reference_t<decltype(*std::begin(val))>>;
+    if constexpr (!std::is_scalar_v<elem_type>) {
+      for (const auto& elem : val) {
+        value(elem, depth);
+      }
+    }
+  }
+
+  template <typename String>
+  void string(const String& val, std::size_t depth)
+  {
+    using char_type = typename String::value_type;
+    // Short strings are kept inside the object
+    const auto object = reinterpret_cast<std::uintptr_t>(std::addressof(val));
+    const auto data = reinterpret_cast<std::uintptr_t>(val.data());
+    if (data >= object && data < object + sizeof(val)) {
+      return;
+    }
+    allocate(depth, val.size() * sizeof(char_type),
+             (val.capacity() + 1) * sizeof(char_type));
+  }
+
+  template <typename P>
+  void owned(const P* ptr, std::size_t overhead, std::size_t depth)
+  {
+    // Neither the length of arrays nor the contents of void are known
+    if constexpr (!std::is_void_v<P> && !std::is_array_v<P>) {
+      if (ptr == nullptr) {
+        return;
+      }
+      if (pointer_trail::is_too_deep()) {
+        is_partial_ = true;
+        return;
+      }
+      const pointer_trail trail{ptr};
+      allocate(depth, sizeof(P), sizeof(P) + overhead);
+      value(*ptr, depth + 1);
+    }
+  }
+
+  template <typename Container>
+  void nodes(const Container& val, std::size_t size, std::size_t links,
+             std::size_t depth)
+  {
+    using elem_type = typename Container::value_type;
+    allocate(depth, size * sizeof(elem_type),
+             size * node_size<elem_type>(links));
+    elements(val, depth + 1);
+  }
+
+  template <typename T, typename Al>
+  void deque(const std::deque<T, Al>& val, std::size_t depth)
+  {
+    const auto per_block =
+        sizeof(T) < deque_block_size ? deque_block_size / sizeof(T) : 1;
+    const auto blocks = val.size() / per_block + 1;
+    const auto map = std::max(deque_min_map_size, blocks + 2);
+    allocate(depth, val.size() * sizeof(T),
+             blocks * per_block * sizeof(T) + map * sizeof(T*));
+    elements(val, depth + 1);
+  }
+
+private:
+  std::vector<footprint::level> levels_;
+  std::unordered_set<const void*> shared_;
+  bool is_partial_{false};
+};
+
+} // namespace detail::heap
+
+// Visits every element that could own memory, which costs O(size)
+template <typename T>
+footprint footprint_of(const T& val)
+{
+  detail::heap::counter counter;
+  counter.value(val, 0);
+  auto res = counter.result();
+  res.inline_size = sizeof(T);
+  return res;
+}
+
+inline void pretty_print(ostream& os, const footprint& val)
+{
+  os << "{inline: " << val.inline_size << ", used: " << val.used
+     << ", reserved: " << val.reserved << ", slack: " << val.slack()
+     << ", levels: [";
+  const char* separator = "";
+  for (const auto& level : val.levels) {
+    os << separator << "{used: " << level.used
+       << ", reserved: " << level.reserved << ", slack: " << level.slack()
+       << '}';
+    separator = ", ";
+  }
+  os << ']';
+  if (val.is_partial) {
+    os << ", warning: pointers nested too deep were not followed";
+  }
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const footprint& val)
+{
+  json.begin_object();
+  json.key("inline_size");
+  json.number(val.inline_size);
+  json.key("used");
+  json.number(val.used);
+  json.key("reserved");
+  json.number(val.reserved);
+  json.key("slack");
+  json.number(val.slack());
+  json.key("levels");
+  json.begin_array();
+  for (const auto& level : val.levels) {
+    json.begin_object();
+    json.key("used");
+    json.number(level.used);
+    json.key("reserved");
+    json.number(level.reserved);
+    json.key("slack");
+    json.number(level.slack());
+    json.end_object();
+  }
+  json.end_array();
+  json.key("partial");
+  json.boolean(val.is_partial);
+  json.end_object();
+}
+
+} // namespace jdbg
@@ -1,112 +1,545 @@
 #pragma once
 
+#include <jdbg/buckets.hpp>
+#include <jdbg/detail/core.hpp>
+#include <jdbg/detail/flush_hooks.hpp>
+#include <jdbg/detail/hash.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/detail/thread.hpp>
+#include <jdbg/diff.hpp>
+#include <jdbg/dump.hpp>
+#include <jdbg/fingerprint.hpp>
+#include <jdbg/footprint.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/layout.hpp>
+#include <jdbg/mem.hpp>
+#include <jdbg/perf.hpp>
 #include <jdbg/pretty_print.hpp>
+#include <jdbg/scope.hpp>
+#include <jdbg/snapshot.hpp>
+#include <jdbg/summary.hpp>
 #include <jdbg/type_name.hpp> // NOLINT
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
 #include <cstdio>
-#include <iostream>
-#include <sstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#ifndef JDBG_NO_IOSTREAM
+#include <iostream>
+#endif
 
 #include <unistd.h>
 
 #ifndef JDBG_LOG_FUNCTION
-#define JDBG_LOG_FUNCTION(str) std::cerr << (str) << '\n'
+#define JDBG_LOG_FUNCTION(str) jdbg::detail::log_line(str)
 #endif
 
 #ifndef JDBG_IS_OUTPUT_COLOURED
 #define JDBG_IS_OUTPUT_COLOURED (isatty(fileno(stderr)) != 0) // NOLINT
 #endif
 
+#ifndef JDBG_IS_OUTPUT_JSON
+#define JDBG_IS_OUTPUT_JSON (false)
+#endif
+
+// Side file of dbg_snapshot(), nullptr for jdbg-<pid>.snap
+#ifndef JDBG_SNAPSHOT_PATH
+#define JDBG_SNAPSHOT_PATH (nullptr)
+#endif
+
+// Trace file of dbg_scope(), nullptr for jdbg-<pid>.trace.json
+#ifndef JDBG_TRACE_PATH
+#define JDBG_TRACE_PATH (nullptr)
+#endif
+
 namespace jdbg::detail {
 
+// The newline goes out in the same write as the record, otherwise lines
+// printed concurrently from several threads can interleave
+inline void log_line(std::string& record)
+{
+  record += '\n';
+#ifndef JDBG_NO_IOSTREAM
+  std::cerr << record;
+#else
+  const char* data = record.data();
+  auto left = record.size();
+  while (left > 0) {
+    const auto written = ::write(STDERR_FILENO, data, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += written;
+    left -= static_cast<std::size_t>(written);
+  }
+#endif
+}
+
+// Sink handed to the core, so JDBG_LOG_FUNCTION is expanded only here
+inline void log_record(std::string& record)
+{
+  JDBG_LOG_FUNCTION(record);
+}
+
+inline trace::thread_buffer& trace_buffer()
+{
+  return trace::local_buffer(JDBG_TRACE_PATH);
+}
+
+template <typename T>
+void format_value(std::string& out, const void* ptr, bool json)
+{
+  const auto& val = *static_cast<const T*>(ptr);
+  if (json) {
+    json_writer writer{out};
+    json_print(writer, val);
+    return;
+  }
+  string_ostream os;
+  pretty_print(os, val);
+  out += os.str();
+}
+
+template <typename T>
+erased_value erase(const T& val)
+{
+  return {std::addressof(val), &format_value<T>};
+}
+
+// Computed once per type, and only when a record is actually printed
+template <typename T>
+const std::string& cached_type_name()
+{
+  static const std::string name = get_type_name<T>();
+  return name;
+}
+
 class output {
 public:
   output(const char* file, int line, const char* func, // NOLINT
          const char* expr)
-      : file_{file}, line_{line}, func_{func}, expr_{expr}
+      : site_{file,
+              line,
+              func,
+              expr,
+              JDBG_IS_OUTPUT_COLOURED,
+              JDBG_IS_OUTPUT_JSON,
+              &log_record}
+  {
+  }
+
+  template <typename T>
+  T&& print(type_name_fn type, T&& val)
+  {
+    print_record(site_, type, erase(val));
+    return std::forward<T>(val);
+  }
 
+  template <int N>
+  const char (&print(type_name_fn /*type*/, const char (&val)[N]))[N]
   {
-    const auto leaf_indicator = file_.find_last_of('/');
-    if (leaf_indicator != std::string::npos) {
-      file_ = file_.substr(leaf_indicator + 1);
+    // For dbg("...") usage do not print expression and type
+    const char* const str = val;
+    print_message(site_, erase(str));
+    return val;
+  }
+
+  // Site is a unique type per call site giving each one its own snapshot
+  template <typename Site, typename T>
+  T&& print_diff(type_name_fn type, Site /*site*/, T&& val)
+  {
+    using state_type = diff_state<std::remove_cv_t<std::remove_reference_t<T>>>;
+    static state_type state;
+
+    const mem::pause no_count;
+    string_ostream diff;
+    const auto result = state.update(diff, val);
+    if (result == state_type::result::unchanged) {
+      return std::forward<T>(val);
+    }
+    if (result == state_type::result::initial) {
+      return print(type, std::forward<T>(val));
     }
+
+    // Diffs are plain text, only quoted when they become a JSON string
+    const auto str = diff.str();
+    const std::string_view text{str};
+    print_record(site_, type, {&text, &format_text}, "diff");
+    return std::forward<T>(val);
   }
 
+  template <typename Site, typename T>
+  T&& print_dedup(type_name_fn type, Site site, T&& val);
+
+  // Statistics of a contiguous range of numbers instead of its elements
   template <typename T>
-  T&& print(const std::string& type, T&& val)
+  T&& print_summary(type_name_fn type, T&& val)
   {
-    std::stringstream out;
-    print_header(out);
-    print_expr(out);
-    print_val(out, val);
-    print_type(out, type);
-    JDBG_LOG_FUNCTION(out.str());
+    const auto summary = jdbg::summarize(val);
+    print_record(site_, type, erase(summary), "summary");
+    return std::forward<T>(val);
+  }
 
+  // How the elements of an unordered container spread over its buckets
+  template <typename T>
+  T&& print_buckets(type_name_fn type, T&& val)
+  {
+    const auto stats = jdbg::analyze_buckets(val);
+    print_record(site_, type, erase(stats), "buckets");
     return std::forward<T>(val);
   }
 
-  template <int N>
-  const char (&print(const std::string& /*type*/, const char (&val)[N]))[N]
+  // A structural hash of the value instead of the value
+  template <typename T>
+  T&& print_hash(type_name_fn type, T&& val)
   {
-    // For dbg("...") usage do not print expression and type
-    std::stringstream out;
-    print_header(out);
-    print_val(out, val);
-    JDBG_LOG_FUNCTION(out.str());
+    const mem::pause no_count;
+    const auto hash = jdbg::fingerprint_of(val);
+    print_record(site_, type, erase(hash), "hash");
+    return std::forward<T>(val);
+  }
 
-    return val;
+  // Heap memory the value owns, level by level
+  template <typename T>
+  T&& print_footprint(type_name_fn type, T&& val)
+  {
+    const mem::pause no_count;
+    const auto footprint = jdbg::footprint_of(val);
+    print_record(site_, type, erase(footprint), "footprint");
+    return std::forward<T>(val);
   }
 
-private:
-  void print_header(std::ostream& os)
+  // Field offsets and padding of the object, as it is placed in memory
+  template <typename T>
+  T&& print_layout(type_name_fn type, T&& val)
+  {
+    const mem::pause no_count;
+    const auto layout = jdbg::layout_of(val);
+    print_record(site_, type, erase(layout), "layout");
+    return std::forward<T>(val);
+  }
+
+  // The same for a type, with no object to look at
+  template <typename T>
+  void print_layout_of(type_name_fn type)
+  {
+    const mem::pause no_count;
+    const auto layout = jdbg::layout_of<T>();
+    print_record(site_, type, erase(layout), "layout");
+  }
+
+  // Writes the whole container to path, printing only where it went
+  template <typename T>
+  T&& print_dump(type_name_fn type, const char* path, T&& val)
+  {
+    const mem::pause no_count;
+    const auto result = jdbg::dump(path, val, site_.is_json);
+    const auto str = dump::describe(result, path);
+    const std::string_view text{str};
+    print_record(site_, type, {&text, &format_text}, "dump");
+    return std::forward<T>(val);
+  }
+
+  // Appends the raw elements to the snapshot file, printing where they went
+  template <typename T>
+  T&& print_snapshot(type_name_fn type, T&& val)
+  {
+    const mem::pause no_count;
+    const auto ref = jdbg::snapshot(val, JDBG_SNAPSHOT_PATH);
+    print_record(site_, type, erase(ref), "snapshot");
+    return std::forward<T>(val);
+  }
+
+  // Evaluates the expression between two reads of the thread's counters
+  template <typename Fn>
+  decltype(auto) print_perf(type_name_fn type, Fn&& fn)
+  {
+    const auto& counters = perf::local_counters();
+    return measure(
+        fn, [&] { return counters.read(); },
+        [&](const perf_sample& before, const perf_sample& after) {
+          print_record(site_, type, erase(perf::difference(before, after)),
+                       "perf");
+        });
+  }
+
+  // Heap use of the calling thread during the evaluation
+  template <typename Fn>
+  decltype(auto) print_mem(type_name_fn type, Fn&& fn)
+  {
+    return measure(fn, &mem::read,
+                   [&](const mem_sample& before, const mem_sample& after) {
+                     print_record(site_, type,
+                                  erase(mem::difference(before, after)), "mem");
+                   });
+  }
+
+  // Sum the samples per call site instead, printed by jdbg::flush() and at
+  // exit
+  template <typename Site, typename Fn>
+  decltype(auto) print_perf_sum(type_name_fn type, Site site, Fn&& fn);
+
+  template <typename Site, typename Fn>
+  decltype(auto) print_mem_sum(type_name_fn type, Site site, Fn&& fn);
+
+  void print_totals(type_name_fn type, erased_value totals,
+                    const char* json_key) const
   {
-    os << ansi(ansi_faint) << '[' << file_ << ':' << line_ << " (" << func_
-       << ")] " << ansi(ansi_reset);
+    print_record(site_, type, totals, json_key);
   }
 
-  void print_expr(std::ostream& os)
+  void print_repeated(std::size_t count) const
   {
-    os << ansi(ansi_cyan) << expr_ << ansi(ansi_reset) << ": ";
+    detail::print_repeated(site_, count);
+  }
+
+private:
+  // Calls fn() between two calls of read() and hands both results to
+  // report(), then forwards what fn() returned
+  template <typename Fn, typename Read, typename Report>
+  static decltype(auto) measure(Fn& fn, Read&& read, Report&& report)
+  {
+    using result_type = decltype(fn());
+    const auto before = read();
+    if constexpr (std::is_void_v<result_type>) {
+      fn();
+      report(before, read());
+    } else {
+      result_type result = fn();
+      report(before, read());
+      if constexpr (std::is_reference_v<result_type>) {
+        return static_cast<result_type>(result);
+      } else {
+        return result;
+      }
+    }
   }
 
   template <typename T>
-  void print_val(std::ostream& os, const T& val)
+  std::string format(const T& val) const
+  {
+    std::string out;
+    format_value<T>(out, std::addressof(val), site_.is_json);
+    return out;
+  }
+
+private:
+  site_info site_;
+};
+
+class dedup_state;
+
+// Every live per call site state with output pending until its flush(),
+// e.g. repeat counts of dbg_dedup()
+template <typename State>
+class state_registry {
+public:
+  static state_registry& instance()
+  {
+    static state_registry registry;
+    return registry;
+  }
+
+  void add(State* state)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    states_.push_back(state);
+  }
+
+  void remove(State* state)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    states_.erase(std::remove(states_.begin(), states_.end(), state),
+                  states_.end());
+  }
+
+  void flush()
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (auto* state : states_) {
+      state->flush();
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<State*> states_;
+};
+
+using dedup_registry = state_registry<dedup_state>;
+
+// Last value seen at a single dbg_dedup() call site, dbg() is one as well
+// when JDBG_DEDUP is defined
+class dedup_state {
+public:
+  explicit dedup_state(const output& out) : out_{out}
+  {
+    dedup_registry::instance().add(this);
+  }
+
+  ~dedup_state()
+  {
+    dedup_registry::instance().remove(this);
+    flush();
+  }
+
+  dedup_state(const dedup_state&) = delete;
+  dedup_state& operator=(const dedup_state&) = delete;
+
+  // Calls print() unless the bytes of the value repeat the previous ones.
+  // The hash only rules out changes early, equal hashes of different bytes
+  // must not hide a change.
+  template <typename Print>
+  void update(std::uint64_t hash, std::string_view bytes, Print&& print)
   {
-    os << ansi(ansi_bold);
-    pretty_print(os, val);
-    os << ansi(ansi_reset);
+    const std::lock_guard<std::mutex> lock{mutex_};
+
+    if (has_last_ && hash == last_hash_ && bytes == last_) {
+      ++repeats_;
+      return;
+    }
+    flush_locked();
+    has_last_ = true;
+    last_hash_ = hash;
+    last_.assign(bytes.data(), bytes.size());
+    print();
   }
 
-  void print_type(std::ostream& os, const std::string& type)
+  void flush()
   {
-    os << " (" << ansi(ansi_green) << type << ansi(ansi_reset) << ")";
+    const std::lock_guard<std::mutex> lock{mutex_};
+    flush_locked();
   }
 
-  const char* ansi(const char* code) const
+private:
+  void flush_locked()
   {
-    if (is_coloured_) {
-      return code;
+    if (repeats_ > 0) {
+      out_.print_repeated(repeats_);
+      repeats_ = 0;
     }
-    return ansi_empty;
   }
 
 private:
-  static constexpr const char* const ansi_empty = "";
-  static constexpr const char* const ansi_bold = "\x1b[01m";
-  static constexpr const char* const ansi_faint = "\x1b[02m";
-  static constexpr const char* const ansi_green = "\x1b[32m";
-  static constexpr const char* const ansi_cyan = "\x1b[36m";
-  static constexpr const char* const ansi_reset = "\x1b[0m";
-
-  std::string file_;
-  int line_;
-  std::string func_;
-  std::string expr_;
-  bool is_coloured_{JDBG_IS_OUTPUT_COLOURED};
+  std::mutex mutex_;
+  output out_;
+  bool has_last_{false};
+  std::uint64_t last_hash_{0};
+  std::string last_;
+  std::size_t repeats_{0};
 };
 
+// Sums of a single dbg_perf_sum() or dbg_mem_sum() call site
+template <typename Totals>
+class totals_state {
+public:
+  totals_state(const output& out, type_name_fn type, const char* json_key)
+      : out_{out}, type_{type}, json_key_{json_key}
+  {
+    state_registry<totals_state>::instance().add(this);
+  }
+
+  ~totals_state()
+  {
+    state_registry<totals_state>::instance().remove(this);
+    flush();
+  }
+
+  totals_state(const totals_state&) = delete;
+  totals_state& operator=(const totals_state&) = delete;
+
+  template <typename Sample>
+  void add(const Sample& sample)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    totals_.add(sample);
+  }
+
+  void flush()
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (totals_.calls > 0) {
+      out_.print_totals(type_, erase(totals_), json_key_);
+      totals_ = {};
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  output out_;
+  type_name_fn type_;
+  const char* json_key_;
+  Totals totals_;
+};
+
+template <typename Site, typename Fn>
+decltype(auto) output::print_perf_sum(type_name_fn type, Site /*site*/,
+                                      Fn&& fn)
+{
+  static totals_state<perf_totals> state{*this, type, "perf"};
+
+  const auto& counters = perf::local_counters();
+  return measure(
+      fn, [&] { return counters.read(); },
+      [](const perf_sample& before, const perf_sample& after) {
+        state.add(perf::difference(before, after));
+      });
+}
+
+template <typename Site, typename Fn>
+decltype(auto) output::print_mem_sum(type_name_fn type, Site /*site*/,
+                                     Fn&& fn)
+{
+  static totals_state<mem_totals> state{*this, type, "mem"};
+
+  return measure(fn, &mem::read,
+                 [](const mem_sample& before, const mem_sample& after) {
+                   const mem::pause no_count;
+                   state.add(mem::difference(before, after));
+                 });
+}
+
+// Values whose bytes fully determine their output can skip formatting
+template <typename T>
+constexpr bool is_raw_hashable_v = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+template <typename Site, typename T>
+T&& output::print_dedup(type_name_fn type, Site /*site*/, T&& val)
+{
+  const mem::pause no_count;
+  static dedup_state state{*this};
+
+  if constexpr (is_raw_hashable_v<std::decay_t<T>>) {
+    const std::string_view bytes{reinterpret_cast<const char*>(&val),
+                                 sizeof(val)};
+    state.update(hash_bytes(bytes.data(), bytes.size()), bytes,
+                 [&] { print(type, val); });
+  } else {
+    const auto formatted = format(val);
+    const std::string_view text{formatted};
+    state.update(hash_bytes(text.data(), text.size()), text, [&] {
+      if constexpr (std::is_array_v<std::remove_reference_t<T>>) {
+        print_message(site_, {&text, &format_raw});
+      } else {
+        print_record(site_, type, {&text, &format_raw});
+      }
+    });
+  }
+  return std::forward<T>(val);
+}
+
 template <typename T>
 T&& forward(T&& t)
 {
@@ -115,13 +548,117 @@ T&& forward(T&& t)
 
 } // namespace jdbg::detail
 
+namespace jdbg {
+
+// Prints the pending "(repeated N times)" lines of all dbg() call sites and
+// the dbg_perf_sum() and dbg_mem_sum() totals since the previous flush, then
+// has sinks such as compressed_file_sink write out what they buffer
+inline void flush()
+{
+  detail::dedup_registry::instance().flush();
+  detail::state_registry<detail::totals_state<perf_totals>>::instance()
+      .flush();
+  detail::state_registry<detail::totals_state<mem_totals>>::instance()
+      .flush();
+  detail::flush_hooks::instance().run();
+}
+
+} // namespace jdbg
+
 #ifndef JDBG_DISABLE
+#ifndef JDBG_DEDUP
 #define dbg(...)                                                               \
   jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
-      .print(jdbg::get_type_name<decltype(__VA_ARGS__)>(), __VA_ARGS__)
+      .print(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,            \
+             __VA_ARGS__)
+#else
+#define dbg(...) dbg_dedup(__VA_ARGS__)
+#endif
+#define dbg_dedup(...)                                                         \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_dedup(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,      \
+                   [] {}, __VA_ARGS__)
+#define dbg_diff(...)                                                          \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_diff(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,       \
+                  [] {}, __VA_ARGS__)
+#define dbg_summary(...)                                                       \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_summary(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,    \
+                     __VA_ARGS__)
+#define dbg_buckets(...)                                                       \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_buckets(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,    \
+                     __VA_ARGS__)
+#define dbg_hash(...)                                                          \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_hash(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,       \
+                  __VA_ARGS__)
+#define dbg_footprint(...)                                                     \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_footprint(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,  \
+                       __VA_ARGS__)
+#define dbg_layout(...)                                                        \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_layout(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,     \
+                    __VA_ARGS__)
+#define dbg_layout_of(...)                                                     \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_layout_of<__VA_ARGS__>(                                           \
+          jdbg::detail::cached_type_name<__VA_ARGS__>)
+#define dbg_dump(expr, path)                                                   \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #expr)                    \
+      .print_dump(jdbg::detail::cached_type_name<decltype(expr)>, path, expr)
+#define dbg_snapshot(...)                                                      \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_snapshot(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,   \
+                      __VA_ARGS__)
+#define dbg_perf(...)                                                          \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_perf(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,       \
+                  [&]() -> decltype(auto) { return (__VA_ARGS__); })
+#define dbg_perf_sum(...)                                                      \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_perf_sum(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,   \
+                      [] {}, [&]() -> decltype(auto) { return (__VA_ARGS__); })
+#define dbg_mem(...)                                                           \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_mem(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,        \
+                 [&]() -> decltype(auto) { return (__VA_ARGS__); })
+#define dbg_mem_sum(...)                                                       \
+  jdbg::detail::output(__FILE__, __LINE__, __func__, #__VA_ARGS__)             \
+      .print_mem_sum(jdbg::detail::cached_type_name<decltype(__VA_ARGS__)>,    \
+                     [] {}, [&]() -> decltype(auto) { return (__VA_ARGS__); })
+#define JDBG_SCOPE_NAME(prefix, line) JDBG_SCOPE_NAME_(prefix, line)
+#define JDBG_SCOPE_NAME_(prefix, line) jdbg_##prefix##line
+#define dbg_scope(name)                                                        \
+  static const jdbg::detail::trace::site JDBG_SCOPE_NAME(site_, __LINE__){     \
+      name, __FILE__, __LINE__, __func__};                                     \
+  const jdbg::detail::trace::scope JDBG_SCOPE_NAME(scope_, __LINE__)           \
+  {                                                                            \
+    JDBG_SCOPE_NAME(site_, __LINE__), jdbg::detail::trace_buffer()             \
+  }
 #else
 #define dbg(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_dedup(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_diff(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_summary(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_buckets(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_hash(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_footprint(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_layout(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_layout_of(...) static_cast<void>(0)
+#define dbg_dump(expr, path) jdbg::detail::forward(expr)
+#define dbg_snapshot(...) jdbg::detail::forward(__VA_ARGS__)
+#define dbg_perf(...) (__VA_ARGS__)
+#define dbg_perf_sum(...) (__VA_ARGS__)
+#define dbg_mem(...) (__VA_ARGS__)
+#define dbg_mem_sum(...) (__VA_ARGS__)
+#define dbg_scope(name) static_cast<void>(0)
 #endif
 
 #undef JDBG_LOG_FUNCTION
 #undef JDBG_IS_OUTPUT_COLOURED
+#undef JDBG_IS_OUTPUT_JSON
+#undef JDBG_SNAPSHOT_PATH
+#undef JDBG_TRACE_PATH
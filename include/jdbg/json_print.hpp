@@ -0,0 +1,673 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/pointer_trail.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/detail/writer.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace jdbg {
+
+namespace detail {
+
+// Bytes of the well-formed UTF-8 sequence starting at str[i], 0 if there
+// is none. Overlong forms, surrogates and code points past U+10FFFF are
+// rejected as JSON parsers do.
+inline std::size_t utf8_length(std::string_view str, std::size_t i)
+{
+  const auto byte = [&](std::size_t at) {
+    return at < str.size() ? static_cast<unsigned char>(str[at]) : 0U;
+  };
+  const auto lead = byte(i);
+  std::size_t length = 0;
+  unsigned min = 0x80;
+  unsigned max = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    min = lead == 0xE0 ? 0xA0 : min;
+    max = lead == 0xED ? 0x9F : max;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    min = lead == 0xF0 ? 0x90 : min;
+    max = lead == 0xF4 ? 0x8F : max;
+  } else {
+    return 0;
+  }
+  // Only the first continuation byte has a narrower range
+  if (byte(i + 1) < min || byte(i + 1) > max) {
+    return 0;
+  }
+  for (std::size_t k = 2; k < length; ++k) {
+    if (byte(i + k) < 0x80 || byte(i + k) > 0xBF) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+// Recursive descent over RFC 8259 JSON, only telling whether text parses
+class json_checker {
+public:
+  explicit json_checker(std::string_view text) : text_{text} {}
+
+  bool is_object()
+  {
+    skip_space();
+    if (peek() != '{' || !value(0)) {
+      return false;
+    }
+    skip_space();
+    return pos_ == text_.size();
+  }
+
+private:
+  // Deeper nesting is rejected rather than risking the stack
+  static constexpr std::size_t max_depth = 64;
+
+  char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+  bool consume(char c)
+  {
+    if (peek() != c) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool consume(std::string_view word)
+  {
+    if (text_.substr(pos_, word.size()) != word) {
+      return false;
+    }
+    pos_ += word.size();
+    return true;
+  }
+
+  void skip_space()
+  {
+    while (peek() == ' ' || peek() == '\t' || peek() == '\n' ||
+           peek() == '\r') {
+      ++pos_;
+    }
+  }
+
+  bool value(std::size_t depth)
+  {
+    skip_space();
+    switch (peek()) {
+    case '{':
+      return depth < max_depth && object(depth + 1);
+    case '[':
+      return depth < max_depth && array(depth + 1);
+    case '"':
+      return string();
+    case 't':
+      return consume("true");
+    case 'f':
+      return consume("false");
+    case 'n':
+      return consume("null");
+    default:
+      return number();
+    }
+  }
+
+  bool object(std::size_t depth)
+  {
+    ++pos_;
+    skip_space();
+    if (consume('}')) {
+      return true;
+    }
+    do {
+      skip_space();
+      if (!string()) {
+        return false;
+      }
+      skip_space();
+      if (!consume(':') || !value(depth)) {
+        return false;
+      }
+      skip_space();
+    } while (consume(','));
+    return consume('}');
+  }
+
+  bool array(std::size_t depth)
+  {
+    ++pos_;
+    skip_space();
+    if (consume(']')) {
+      return true;
+    }
+    do {
+      if (!value(depth)) {
+        return false;
+      }
+      skip_space();
+    } while (consume(','));
+    return consume(']');
+  }
+
+  bool string()
+  {
+    if (!consume('"')) {
+      return false;
+    }
+    while (pos_ < text_.size()) {
+      const auto c = static_cast<unsigned char>(text_[pos_]);
+      if (c == '"') {
+        ++pos_;
+        return true;
+      }
+      if (c < 0x20) {
+        return false;
+      }
+      if (c >= 0x80) {
+        const auto length = utf8_length(text_, pos_);
+        if (length == 0) {
+          return false;
+        }
+        pos_ += length;
+      } else if (c == '\\') {
+        ++pos_;
+        if (!escape()) {
+          return false;
+        }
+      } else {
+        ++pos_;
+      }
+    }
+    return false;
+  }
+
+  bool escape()
+  {
+    const auto c = peek();
+    ++pos_;
+    if (c == 'u') {
+      for (int i = 0; i < 4; ++i) {
+        if (!is_hex(peek())) {
+          return false;
+        }
+        ++pos_;
+      }
+      return true;
+    }
+    return c == '"' || c == '\\' || c == '/' || c == 'b' || c == 'f' ||
+           c == 'n' || c == 'r' || c == 't';
+  }
+
+  bool number()
+  {
+    consume('-');
+    if (!consume('0')) {
+      if (!digits()) {
+        return false;
+      }
+    }
+    if (consume('.') && !digits()) {
+      return false;
+    }
+    if (consume('e') || consume('E')) {
+      if (!consume('+')) {
+        consume('-');
+      }
+      return digits();
+    }
+    return true;
+  }
+
+  bool digits()
+  {
+    const auto start = pos_;
+    while (peek() >= '0' && peek() <= '9') {
+      ++pos_;
+    }
+    return pos_ != start;
+  }
+
+  static bool is_hex(char c)
+  {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+           (c >= 'A' && c <= 'F');
+  }
+
+private:
+  std::string_view text_;
+  std::size_t pos_{0};
+};
+
+// Whether text is exactly one JSON object, e.g. a record of a JSON sink
+inline bool is_json_object(std::string_view text)
+{
+  return json_checker{text}.is_object();
+}
+
+} // namespace detail
+
+// Streaming JSON writer appending straight into a caller-owned buffer
+class json_writer {
+public:
+  explicit json_writer(std::string& buf) : out_{buf} {}
+
+  void null()
+  {
+    separate();
+    out_.write("null");
+  }
+
+  void boolean(bool val)
+  {
+    separate();
+    out_.write(val ? "true" : "false");
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T>, void> number(T val)
+  {
+    separate();
+    out_.write_integer(val);
+  }
+
+  // JSON has no representation for NaN and infinities, emit them as strings
+  template <typename T>
+  std::enable_if_t<std::is_floating_point_v<T>, void> number(T val)
+  {
+    if (std::isnan(val)) {
+      string("nan");
+    } else if (std::isinf(val)) {
+      string(val < 0 ? "-inf" : "inf");
+    } else {
+      separate();
+      out_.write_float(val);
+    }
+  }
+
+  void string(std::string_view val)
+  {
+    separate();
+    escape(val);
+  }
+
+  // Already serialised JSON value
+  void raw(std::string_view json)
+  {
+    separate();
+    out_.write(json);
+  }
+
+  void key(std::string_view name)
+  {
+    separate();
+    escape(name);
+    out_.put(':');
+    need_comma_ = false;
+  }
+
+  void begin_object() { open('{'); }
+
+  void end_object() { close('}'); }
+
+  void begin_array() { open('['); }
+
+  void end_array() { close(']'); }
+
+private:
+  void separate()
+  {
+    if (need_comma_) {
+      out_.put(',');
+    }
+    need_comma_ = true;
+  }
+
+  void open(char bracket)
+  {
+    separate();
+    out_.put(bracket);
+    need_comma_ = false;
+  }
+
+  void close(char bracket)
+  {
+    out_.put(bracket);
+    need_comma_ = true;
+  }
+
+  void escape(std::string_view str)
+  {
+    out_.put('"');
+    std::size_t plain = 0;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+      const auto c = static_cast<unsigned char>(str[i]);
+      if (c >= 0x80) {
+        const auto length = detail::utf8_length(str, i);
+        if (length != 0) {
+          i += length - 1;
+          continue;
+        }
+        // Not UTF-8, e.g. Latin-1 or a sequence cut short, each such byte
+        // becomes a replacement character
+        out_.write(str.substr(plain, i - plain));
+        plain = i + 1;
+        out_.write("\\ufffd");
+        continue;
+      }
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        continue;
+      }
+      out_.write(str.substr(plain, i - plain));
+      plain = i + 1;
+      switch (c) {
+      case '"':
+        out_.write("\\\"");
+        break;
+      case '\\':
+        out_.write("\\\\");
+        break;
+      case '\n':
+        out_.write("\\n");
+        break;
+      case '\r':
+        out_.write("\\r");
+        break;
+      case '\t':
+        out_.write("\\t");
+        break;
+      default:
+        out_.write("\\u00");
+        out_.write_hex(c, 2);
+        break;
+      }
+    }
+    out_.write(str.substr(plain));
+    out_.put('"');
+  }
+
+private:
+  detail::writer out_;
+  bool need_comma_{false};
+};
+
+template <typename T>
+void json_print(json_writer& json, const T& val, std::true_type /*true*/)
+{
+  // Types only printable through operator<< become JSON strings
+  detail::string_ostream os;
+  os << val;
+  json.string(os.str());
+}
+
+template <typename T>
+void json_print(json_writer& /*json*/, const T& /*val*/,
+                std::false_type /*false*/)
+{
+  static_assert(detail::has_ostream_operator<T>::value,
+                "This type does not support the ostream operator<<");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::enable_if_t<!detail::is_container<T>::value && !std::is_enum_v<T> &&
+                     !std::is_arithmetic_v<T>,
+                 void>
+json_print(json_writer& json, const T& val);
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic_v<T>, void> json_print(json_writer& json,
+                                                           const T& val);
+
+inline void json_print(json_writer& json, const bool& val);
+
+inline void json_print(json_writer& json, const char& val);
+
+template <size_t N>
+void json_print(json_writer& json, const char (&val)[N]);
+
+inline void json_print(json_writer& json, const char* const& val);
+
+inline void json_print(json_writer& json, const std::string& val);
+
+inline void json_print(json_writer& json, std::string_view val);
+
+template <typename P>
+void json_print(json_writer& json, P* const& val);
+
+inline void json_print(json_writer& json, void* const& val);
+
+inline void json_print(json_writer& json, const void* const& val);
+
+template <typename T, typename Deleter>
+void json_print(json_writer& json, const std::unique_ptr<T, Deleter>& val);
+
+template <typename T>
+void json_print(json_writer& json, const std::shared_ptr<T>& val);
+
+template <typename T1, typename T2>
+void json_print(json_writer& json, const std::pair<T1, T2>& val);
+
+template <typename... Ts>
+void json_print(json_writer& json, const std::tuple<Ts...>& val);
+
+template <typename E>
+std::enable_if_t<std::is_enum_v<E>, void> json_print(json_writer& json,
+                                                     const E& val);
+
+template <typename Container>
+std::enable_if_t<detail::is_container<Container>::value, void>
+json_print(json_writer& json, const Container& val);
+
+template <typename T>
+void json_print(json_writer& json, const std::optional<T>& val);
+
+template <typename... Ts>
+void json_print(json_writer& json, const std::variant<Ts...>& val);
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::enable_if_t<!detail::is_container<T>::value && !std::is_enum_v<T> &&
+                     !std::is_arithmetic_v<T>,
+                 void>
+json_print(json_writer& json, const T& val)
+{
+  json_print(json, val, detail::has_ostream_operator<T>{});
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic_v<T>, void> json_print(json_writer& json,
+                                                           const T& val)
+{
+  json.number(val);
+}
+
+inline void json_print(json_writer& json, const bool& val)
+{
+  json.boolean(val);
+}
+
+inline void json_print(json_writer& json, const char& val)
+{
+  json.string(std::string_view{&val, 1});
+}
+
+template <size_t N>
+void json_print(json_writer& json, const char (&val)[N])
+{
+  json.string(std::string_view{val});
+}
+
+inline void json_print(json_writer& json, const char* const& val)
+{
+  if (val == nullptr) {
+    json.null();
+    return;
+  }
+  json.string(val);
+}
+
+inline void json_print(json_writer& json, const std::string& val)
+{
+  json.string(val);
+}
+
+inline void json_print(json_writer& json, std::string_view val)
+{
+  json.string(val);
+}
+
+namespace detail {
+
+inline void json_print_address(json_writer& json, const void* val)
+{
+  std::string buf;
+  writer{buf}.write_pointer(val);
+  json.string(buf);
+}
+
+} // namespace detail
+
+template <typename P>
+void json_print(json_writer& json, P* const& val)
+{
+  if (val == nullptr) {
+    json.null();
+    return;
+  }
+  json.begin_object();
+  json.key("address");
+  detail::json_print_address(json, val);
+  if (detail::pointer_trail::contains(val)) {
+    json.key("cycle");
+    json.boolean(true);
+  } else if (detail::pointer_trail::is_too_deep()) {
+    json.key("truncated");
+    json.boolean(true);
+  } else {
+    const detail::pointer_trail trail{val};
+    json.key("value");
+    json_print(json, *val);
+  }
+  json.end_object();
+}
+
+inline void json_print(json_writer& json, void* const& val)
+{
+  if (val == nullptr) {
+    json.null();
+    return;
+  }
+  detail::json_print_address(json, val);
+}
+
+inline void json_print(json_writer& json, const void* const& val)
+{
+  if (val == nullptr) {
+    json.null();
+    return;
+  }
+  detail::json_print_address(json, val);
+}
+
+template <typename T, typename Deleter>
+void json_print(json_writer& json, const std::unique_ptr<T, Deleter>& val)
+{
+  json_print(json, val.get());
+}
+
+template <typename T>
+void json_print(json_writer& json, const std::shared_ptr<T>& val)
+{
+  json.begin_object();
+  json.key("value");
+  json_print(json, val.get());
+  json.key("refs");
+  json.number(val.use_count());
+  json.end_object();
+}
+
+template <typename T1, typename T2>
+void json_print(json_writer& json, const std::pair<T1, T2>& val)
+{
+  json.begin_array();
+  json_print(json, val.first);
+  json_print(json, val.second);
+  json.end_array();
+}
+
+namespace detail {
+
+template <typename Tuple, std::size_t... Is>
+void json_print_tuple(json_writer& json, const Tuple& val,
+                      std::index_sequence<Is...> /*seq*/)
+{
+  using swallow = int[];
+  (void)swallow{0, ((void)json_print(json, std::get<Is>(val)), 0)...};
+}
+
+} // namespace detail
+
+template <typename... Ts>
+void json_print(json_writer& json, const std::tuple<Ts...>& val)
+{
+  json.begin_array();
+  detail::json_print_tuple(json, val, std::index_sequence_for<Ts...>{});
+  json.end_array();
+}
+
+template <typename E>
+std::enable_if_t<std::is_enum_v<E>, void> json_print(json_writer& json,
+                                                     const E& val)
+{
+  json.number(static_cast<std::underlying_type_t<E>>(val));
+}
+
+template <typename Container>
+std::enable_if_t<detail::is_container<Container>::value, void>
+json_print(json_writer& json, const Container& val)
+{
+  // Unlike pretty_print, the whole container is written so nothing is lost
+  json.begin_array();
+  for (const auto& elem : val) {
+    json_print(json, elem);
+  }
+  json.end_array();
+}
+
+template <typename T>
+void json_print(json_writer& json, const std::optional<T>& val)
+{
+  if (!val.has_value()) {
+    json.null();
+    return;
+  }
+  json_print(json, val.value());
+}
+
+template <typename... Ts>
+void json_print(json_writer& json, const std::variant<Ts...>& val)
+{
+  json.begin_object();
+  json.key("index");
+  json.number(val.index());
+  json.key("value");
+  std::visit([&](auto&& arg) { json_print(json, arg); }, val);
+  json.end_object();
+}
+
+} // namespace jdbg
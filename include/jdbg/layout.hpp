@@ -0,0 +1,363 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+#include <jdbg/type_name.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jdbg {
+
+struct field_layout {
+  std::string type;
+  std::size_t offset{0};
+  std::size_t size{0};
+  // Unused bytes between the end of the field before, or the start of the
+  // object, and this one
+  std::size_t padding_before{0};
+  bool straddles_cache_line{false};
+};
+
+// Where the fields of a type sit in memory
+struct type_layout {
+  static constexpr std::size_t cache_line = 64;
+
+  std::size_t size{0};
+  std::size_t alignment{0};
+  // Only aggregates are split into fields
+  bool is_decomposed{false};
+  std::vector<field_layout> fields;
+  // Unused bytes after the last field
+  std::size_t tail_padding{0};
+  // Where the object lives, null when laid out from the type alone
+  const void* address{nullptr};
+
+  std::size_t padding() const
+  {
+    std::size_t total = tail_padding;
+    for (const auto& field : fields) {
+      total += field.padding_before;
+    }
+    return total;
+  }
+
+  // Largest power of two the address is a multiple of
+  std::size_t address_alignment() const
+  {
+    const auto bits = reinterpret_cast<std::uintptr_t>(address);
+    return static_cast<std::size_t>(bits & (~bits + 1));
+  }
+};
+
+namespace detail::layout {
+
+// Converts to any field type, only ever used unevaluated
+struct any_field {
+  template <typename T>
+  operator T() const; // NOLINT
+};
+
+template <std::size_t>
+using any_field_at = any_field;
+
+template <typename T, typename Indices, typename = void>
+struct is_braced_with : std::false_type {};
+
+template <typename T, std::size_t... I>
+struct is_braced_with<T, std::index_sequence<I...>,
+                      std::void_t<decltype(T{any_field_at<I>{}...})>>
+    : std::true_type {};
+
+constexpr std::size_t max_fields = 24;
+
+// Fields of an aggregate, the most initializers T{...} accepts
+template <typename T, std::size_t N = max_fields>
+constexpr std::size_t field_count()
+{
+  if constexpr (N == 0 ||
+                is_braced_with<T, std::make_index_sequence<N>>::value) {
+    return N;
+  } else {
+    return field_count<T, N - 1>();
+  }
+}
+
+template <typename T>
+using tuple_size_t = decltype(std::tuple_size<T>::value);
+
+// Tuple-like aggregates such as std::array would count their elements
+template <typename T>
+constexpr bool is_decomposable = std::is_class_v<T> &&
+                                 std::is_aggregate_v<T> &&
+                                 !is_detected<tuple_size_t, T>::value;
+
+// References to the N fields of obj, in declaration order
+template <std::size_t N, typename T>
+auto tie_fields(T& obj)
+{
+  if constexpr (N == 0) {
+    static_cast<void>(obj);
+    return std::tuple<>{};
+  } else if constexpr (N == 1) {
+    auto& [f0] = obj;
+    return std::tie(f0);
+  } else if constexpr (N == 2) {
+    auto& [f0, f1] = obj;
+    return std::tie(f0, f1);
+  } else if constexpr (N == 3) {
+    auto& [f0, f1, f2] = obj;
+    return std::tie(f0, f1, f2);
+  } else if constexpr (N == 4) {
+    auto& [f0, f1, f2, f3] = obj;
+    return std::tie(f0, f1, f2, f3);
+  } else if constexpr (N == 5) {
+    auto& [f0, f1, f2, f3, f4] = obj;
+    return std::tie(f0, f1, f2, f3, f4);
+  } else if constexpr (N == 6) {
+    auto& [f0, f1, f2, f3, f4, f5] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5);
+  } else if constexpr (N == 7) {
+    auto& [f0, f1, f2, f3, f4, f5, f6] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6);
+  } else if constexpr (N == 8) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+  } else if constexpr (N == 9) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+  } else if constexpr (N == 10) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+  } else if constexpr (N == 11) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+  } else if constexpr (N == 12) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+  } else if constexpr (N == 13) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+  } else if constexpr (N == 14) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+  } else if constexpr (N == 15) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+           f14] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14);
+  } else if constexpr (N == 16) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14,
+           f15] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15);
+  } else if constexpr (N == 17) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16);
+  } else if constexpr (N == 18) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17);
+  } else if constexpr (N == 19) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18);
+  } else if constexpr (N == 20) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18, f19] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18, f19);
+  } else if constexpr (N == 21) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18, f19, f20] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18, f19, f20);
+  } else if constexpr (N == 22) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18, f19, f20, f21] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18, f19, f20, f21);
+  } else if constexpr (N == 23) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18, f19, f20, f21, f22] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18, f19, f20, f21, f22);
+  } else if constexpr (N == 24) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15,
+           f16, f17, f18, f19, f20, f21, f22, f23] = obj;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13,
+                    f14, f15, f16, f17, f18, f19, f20, f21, f22, f23);
+  }
+}
+
+template <typename Field>
+void add_field(type_layout& res, Field& field, const char* base,
+               std::uintptr_t start, std::size_t& end)
+{
+  field_layout entry;
+  entry.type = get_type_name<Field>();
+  entry.offset = static_cast<std::size_t>(
+      reinterpret_cast<const char*>(std::addressof(field)) - base);
+  entry.size = sizeof(Field);
+  // Empty members may share their address with the next field
+  entry.padding_before = entry.offset > end ? entry.offset - end : 0;
+  end = std::max(end, entry.offset + entry.size);
+
+  const auto first = start + entry.offset;
+  entry.straddles_cache_line =
+      entry.size > 0 && first / type_layout::cache_line !=
+                            (first + entry.size - 1) / type_layout::cache_line;
+  res.fields.push_back(std::move(entry));
+}
+
+template <typename T>
+type_layout basic_layout(const void* address)
+{
+  type_layout res;
+  res.size = sizeof(T);
+  res.alignment = alignof(T);
+  res.address = address;
+  return res;
+}
+
+// Takes the address of obj and its fields without reading them
+template <typename T>
+void add_fields(type_layout& res, T& obj)
+{
+  static_assert(
+      !is_braced_with<T, std::make_index_sequence<max_fields + 1>>::value,
+      "layout_of() decomposes aggregates of up to 24 fields");
+  res.is_decomposed = true;
+  const auto* base = reinterpret_cast<const char*>(std::addressof(obj));
+  const auto start = reinterpret_cast<std::uintptr_t>(res.address);
+  std::size_t end = 0;
+  std::apply(
+      [&](auto&... fields) {
+        (add_field(res, fields, base, start, end), ...);
+      },
+      tie_fields<field_count<T>()>(obj));
+  res.tail_padding = res.size - std::min(end, res.size);
+}
+
+// Zeroed storage for a T that is never constructed, only the addresses of
+// its fields are taken
+template <typename T>
+union holder {
+  constexpr holder() : bytes{} {}
+  ~holder() {} // NOLINT
+
+  unsigned char bytes[sizeof(T)];
+  T obj;
+};
+
+} // namespace detail::layout
+
+// Layout of T as if it began a cache line. Aggregates are split into their
+// fields, which must not be references, bit-fields, C arrays or in a base
+// class
+template <typename T>
+type_layout layout_of()
+{
+  auto res = detail::layout::basic_layout<T>(nullptr);
+  if constexpr (detail::layout::is_decomposable<T>) {
+    static detail::layout::holder<T> storage;
+    detail::layout::add_fields(res, storage.obj);
+  }
+  return res;
+}
+
+// Layout of val where it lives, cache lines are counted from its address
+template <typename T>
+type_layout layout_of(const T& val)
+{
+  auto res = detail::layout::basic_layout<T>(std::addressof(val));
+  if constexpr (detail::layout::is_decomposable<T>) {
+    detail::layout::add_fields(res, const_cast<T&>(val));
+  }
+  return res;
+}
+
+inline void pretty_print(ostream& os, const type_layout& val)
+{
+  os << "{size: " << val.size << ", alignment: " << val.alignment;
+  if (val.is_decomposed) {
+    os << ", fields: [";
+    const char* separator = "";
+    for (const auto& field : val.fields) {
+      if (field.padding_before != 0) {
+        os << separator << "{padding: " << field.padding_before << '}';
+        separator = ", ";
+      }
+      os << separator << "{offset: " << field.offset
+         << ", size: " << field.size << ", type: " << field.type;
+      if (field.straddles_cache_line) {
+        os << ", straddles cache line";
+      }
+      os << '}';
+      separator = ", ";
+    }
+    if (val.tail_padding != 0) {
+      os << separator << "{padding: " << val.tail_padding << '}';
+    }
+    os << "], padding: " << val.padding();
+  }
+  if (val.address != nullptr) {
+    os << ", address: ";
+    pretty_print(os, val.address);
+    os << ", address alignment: " << val.address_alignment();
+  }
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const type_layout& val)
+{
+  json.begin_object();
+  json.key("size");
+  json.number(val.size);
+  json.key("alignment");
+  json.number(val.alignment);
+  if (val.is_decomposed) {
+    json.key("fields");
+    json.begin_array();
+    for (const auto& field : val.fields) {
+      json.begin_object();
+      json.key("type");
+      json.string(field.type);
+      json.key("offset");
+      json.number(field.offset);
+      json.key("size");
+      json.number(field.size);
+      json.key("padding_before");
+      json.number(field.padding_before);
+      json.key("straddles_cache_line");
+      json.boolean(field.straddles_cache_line);
+      json.end_object();
+    }
+    json.end_array();
+    json.key("tail_padding");
+    json.number(val.tail_padding);
+    json.key("padding");
+    json.number(val.padding());
+  }
+  if (val.address != nullptr) {
+    json.key("address");
+    detail::json_print_address(json, val.address);
+    json.key("address_alignment");
+    json.number(val.address_alignment());
+  }
+  json.end_object();
+}
+
+} // namespace jdbg
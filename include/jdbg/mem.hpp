@@ -0,0 +1,202 @@
+#pragma once
+
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// The hook used to be defined here, which installed nothing when this
+// header had been included before the macro was defined
+#if defined(JDBG_MEM_HOOK)
+#error "JDBG_MEM_HOOK is gone, include <jdbg/mem_hook.hpp> in one file instead"
+#endif
+
+namespace jdbg {
+
+// Heap use of the calling thread while an expression was evaluated, or
+// summed over several evaluations. Only counted with the allocation hook,
+// which is defined by the one translation unit including
+// <jdbg/mem_hook.hpp>. Bytes include the rounding of the allocator where
+// it can report it.
+struct mem_sample {
+  bool hooked{false};
+  std::uint64_t allocations{0};
+  std::uint64_t frees{0};
+  std::uint64_t allocated{0};
+  std::uint64_t freed{0};
+
+  // Bytes still allocated afterwards, negative when more was freed
+  std::int64_t net() const
+  {
+    return static_cast<std::int64_t>(allocated - freed);
+  }
+};
+
+// Sums over the evaluations at one dbg_mem_sum() call site
+struct mem_totals {
+  std::uint64_t calls{0};
+  mem_sample sum;
+
+  void add(const mem_sample& sample)
+  {
+    ++calls;
+    sum.hooked = sample.hooked;
+    sum.allocations += sample.allocations;
+    sum.frees += sample.frees;
+    sum.allocated += sample.allocated;
+    sum.freed += sample.freed;
+  }
+};
+
+namespace detail::mem {
+
+struct counters {
+  std::uint64_t allocations;
+  std::uint64_t frees;
+  std::uint64_t allocated;
+  std::uint64_t freed;
+  int paused; // jdbg's own allocations are not counted while above 0
+};
+
+// Constant initialised, so the hook reaches it without a TLS wrapper call
+inline thread_local counters local{};
+
+inline bool hooked = false; // NOLINT
+
+// Excludes allocations of jdbg itself, e.g. formatting a record, from the
+// counts of the calling thread
+class pause {
+public:
+  pause() { ++local.paused; }
+
+  ~pause() { --local.paused; }
+
+  pause(const pause&) = delete;
+  pause& operator=(const pause&) = delete;
+};
+
+inline mem_sample read()
+{
+  return {hooked, local.allocations, local.frees, local.allocated,
+          local.freed};
+}
+
+inline mem_sample difference(const mem_sample& before,
+                             const mem_sample& after)
+{
+  return {after.hooked, after.allocations - before.allocations,
+          after.frees - before.frees, after.allocated - before.allocated,
+          after.freed - before.freed};
+}
+
+inline std::size_t usable_size(void* ptr, std::size_t size)
+{
+#if defined(__GLIBC__)
+  static_cast<void>(size);
+  return malloc_usable_size(ptr);
+#else
+  static_cast<void>(ptr);
+  return size;
+#endif
+}
+
+inline void* allocate(std::size_t size, std::size_t alignment)
+{
+  if (size == 0) {
+    size = 1;
+  }
+  for (;;) {
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+      ptr = std::malloc(size);
+    } else if (posix_memalign(&ptr, alignment, size) != 0) {
+      ptr = nullptr;
+    }
+    if (ptr != nullptr) {
+      if (local.paused == 0) {
+        ++local.allocations;
+        local.allocated += usable_size(ptr, size);
+      }
+      return ptr;
+    }
+    const auto handler = std::get_new_handler();
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    handler();
+  }
+}
+
+// Without the allocator's help freed bytes are only known from sized
+// deletes, size is 0 otherwise
+inline void deallocate(void* ptr, std::size_t size)
+{
+  if (ptr == nullptr) {
+    return;
+  }
+  if (local.paused == 0) {
+    ++local.frees;
+    local.freed += usable_size(ptr, size);
+  }
+  std::free(ptr);
+}
+
+} // namespace detail::mem
+
+inline void pretty_print(ostream& os, const mem_sample& val)
+{
+  if (!val.hooked) {
+    os << "{no allocation hook}";
+    return;
+  }
+  os << "{allocations: " << val.allocations << ", frees: " << val.frees
+     << ", allocated: " << val.allocated << ", freed: " << val.freed
+     << ", net: " << val.net() << '}';
+}
+
+inline void json_print(json_writer& json, const mem_sample& val)
+{
+  json.begin_object();
+  json.key("hooked");
+  json.boolean(val.hooked);
+  if (val.hooked) {
+    json.key("allocations");
+    json.number(val.allocations);
+    json.key("frees");
+    json.number(val.frees);
+    json.key("allocated");
+    json.number(val.allocated);
+    json.key("freed");
+    json.number(val.freed);
+    json.key("net");
+    json.number(val.net());
+  }
+  json.end_object();
+}
+
+// Sums, so a leak shows as a net growing with the calls
+inline void pretty_print(ostream& os, const mem_totals& val)
+{
+  os << "{calls: " << val.calls << ", sum: ";
+  pretty_print(os, val.sum);
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const mem_totals& val)
+{
+  json.begin_object();
+  json.key("calls");
+  json.number(val.calls);
+  json.key("sum");
+  json_print(json, val.sum);
+  json.end_object();
+}
+
+} // namespace jdbg
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <jdbg/mem.hpp>
+
+#include <cstddef>
+#include <new>
+
+// The replaceable global allocation functions, counting into the thread's
+// jdbg::detail::mem::local for dbg_mem() and dbg_mem_sum(). Include this
+// header in exactly one translation unit of the program, in any order
+// relative to the other jdbg headers.
+
+namespace jdbg::detail::mem {
+
+inline void* allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+  void* ptr = allocate(size, alignment);
+  if (ptr == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return ptr;
+}
+
+const bool hook_installed = (hooked = true);
+
+} // namespace jdbg::detail::mem
+
+void* operator new(std::size_t size)
+{
+  return jdbg::detail::mem::allocate_or_throw(size, 0);
+}
+
+void* operator new[](std::size_t size)
+{
+  return jdbg::detail::mem::allocate_or_throw(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+  return jdbg::detail::mem::allocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+  return jdbg::detail::mem::allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return jdbg::detail::mem::allocate_or_throw(
+      size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return jdbg::detail::mem::allocate_or_throw(
+      size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t& /*tag*/) noexcept
+{
+  return jdbg::detail::mem::allocate(size,
+                                     static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t& /*tag*/) noexcept
+{
+  return jdbg::detail::mem::allocate(size,
+                                     static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, size);
+}
+
+void operator delete[](void* ptr, std::size_t size) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, size);
+}
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete(void* ptr, std::size_t size,
+                     std::align_val_t /*alignment*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, size);
+}
+
+void operator delete[](void* ptr, std::size_t size,
+                       std::align_val_t /*alignment*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, size);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/,
+                     const std::nothrow_t& /*tag*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*alignment*/,
+                       const std::nothrow_t& /*tag*/) noexcept
+{
+  jdbg::detail::mem::deallocate(ptr, 0);
+}
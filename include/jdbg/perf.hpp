@@ -0,0 +1,256 @@
+#pragma once
+
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jdbg {
+
+namespace detail::perf {
+
+struct counter {
+  std::uint32_t type;
+  std::uint64_t config;
+  const char* name;
+};
+
+#if defined(__linux__)
+// Hardware counters first, the software ones are only used when the CPU
+// cycles cannot be counted, e.g. in most VMs
+constexpr counter counters[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache-misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-clock"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context-switches"},
+};
+constexpr std::size_t hardware_counters = 4;
+#else
+constexpr counter counters[] = {{0, 0, "none"}};
+constexpr std::size_t hardware_counters = 0;
+#endif
+
+constexpr std::size_t counter_count = sizeof(counters) / sizeof(counters[0]);
+
+} // namespace detail::perf
+
+// Counter values read around one evaluation, or summed over several. Bit i
+// of counters is set when detail::perf::counters[i] was read.
+struct perf_sample {
+  std::uint32_t counters{0};
+  std::uint64_t values[detail::perf::counter_count]{};
+};
+
+// Sums over the evaluations at one dbg_perf_sum() call site
+struct perf_totals {
+  std::uint64_t calls{0};
+  perf_sample sum;
+
+  void add(const perf_sample& sample)
+  {
+    sum.counters = calls == 0 ? sample.counters
+                              : sum.counters & sample.counters;
+    ++calls;
+    for (std::size_t i = 0; i < detail::perf::counter_count; ++i) {
+      sum.values[i] += sample.values[i];
+    }
+  }
+};
+
+namespace detail::perf {
+
+// One group of counters for the calling thread, opened on first use and
+// read with a single read(2)
+class thread_counters {
+public:
+  thread_counters()
+  {
+#if defined(__linux__)
+    open_group(0, hardware_counters);
+    if (leader_ < 0) {
+      open_group(hardware_counters, counter_count);
+    }
+#endif
+  }
+
+  ~thread_counters()
+  {
+#if defined(__linux__)
+    for (std::size_t i = 0; i < size_; ++i) {
+      ::close(fds_[i]);
+    }
+#endif
+  }
+
+  thread_counters(const thread_counters&) = delete;
+  thread_counters& operator=(const thread_counters&) = delete;
+
+  perf_sample read() const
+  {
+    perf_sample sample;
+#if defined(__linux__)
+    // PERF_FORMAT_GROUP: the number of counters, then their values
+    std::uint64_t buf[1 + counter_count];
+    if (leader_ < 0 || ::read(leader_, buf, sizeof(buf)) <= 0) {
+      return sample;
+    }
+    for (std::size_t i = 0; i < size_ && i < buf[0]; ++i) {
+      sample.counters |= 1U << index_[i];
+      sample.values[index_[i]] = buf[1 + i];
+    }
+#endif
+    return sample;
+  }
+
+private:
+#if defined(__linux__)
+  // Counters of the kernel are left out where the perf_event_paranoid
+  // setting does not allow them
+  static int open_counter(const counter& ctr, int group)
+  {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = ctr.type;
+    attr.config = ctr.config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_hv = 1;
+    for (int exclude_kernel = 0; exclude_kernel < 2; ++exclude_kernel) {
+      attr.exclude_kernel = static_cast<unsigned>(exclude_kernel);
+      const auto fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, group,
+                                PERF_FLAG_FD_CLOEXEC);
+      if (fd >= 0) {
+        return static_cast<int>(fd);
+      }
+    }
+    return -1;
+  }
+
+  // Members the PMU does not support are skipped, the group is only given
+  // up when its first counter cannot be opened
+  void open_group(std::size_t first, std::size_t last)
+  {
+    for (auto i = first; i < last; ++i) {
+      const int fd = open_counter(counters[i], leader_);
+      if (fd < 0) {
+        if (leader_ < 0) {
+          return;
+        }
+        continue;
+      }
+      if (leader_ < 0) {
+        leader_ = fd;
+      }
+      fds_[size_] = fd;
+      index_[size_] = static_cast<std::uint32_t>(i);
+      ++size_;
+    }
+  }
+#endif
+
+private:
+  int leader_{-1};
+  int fds_[counter_count]{};
+  std::uint32_t index_[counter_count]{};
+  std::size_t size_{0};
+};
+
+inline const thread_counters& local_counters()
+{
+  thread_local const thread_counters counters;
+  return counters;
+}
+
+inline perf_sample difference(const perf_sample& before,
+                              const perf_sample& after)
+{
+  perf_sample sample;
+  sample.counters = before.counters & after.counters;
+  for (std::size_t i = 0; i < counter_count; ++i) {
+    sample.values[i] = after.values[i] - before.values[i];
+  }
+  return sample;
+}
+
+} // namespace detail::perf
+
+// Counter values of the calling thread while it runs fn()
+template <typename Fn>
+perf_sample measure_perf(Fn&& fn)
+{
+  const auto& counters = detail::perf::local_counters();
+  const auto before = counters.read();
+  fn();
+  return detail::perf::difference(before, counters.read());
+}
+
+inline void pretty_print(ostream& os, const perf_sample& val)
+{
+  if (val.counters == 0) {
+    os << "{no perf counters}";
+    return;
+  }
+  os << '{';
+  const char* separator = "";
+  for (std::size_t i = 0; i < detail::perf::counter_count; ++i) {
+    if ((val.counters & (1U << i)) != 0) {
+      os << separator << detail::perf::counters[i].name << ": "
+         << val.values[i];
+      separator = ", ";
+    }
+  }
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const perf_sample& val)
+{
+  json.begin_object();
+  for (std::size_t i = 0; i < detail::perf::counter_count; ++i) {
+    if ((val.counters & (1U << i)) != 0) {
+      json.key(detail::perf::counters[i].name);
+      json.number(val.values[i]);
+    }
+  }
+  json.end_object();
+}
+
+// Means per call
+inline void pretty_print(ostream& os, const perf_totals& val)
+{
+  os << "{calls: " << val.calls;
+  if (val.calls > 0 && val.sum.counters != 0) {
+    os << ", mean: {";
+    const char* separator = "";
+    for (std::size_t i = 0; i < detail::perf::counter_count; ++i) {
+      if ((val.sum.counters & (1U << i)) != 0) {
+        os << separator << detail::perf::counters[i].name << ": ";
+        pretty_print(os, static_cast<double>(val.sum.values[i]) /
+                             static_cast<double>(val.calls));
+        separator = ", ";
+      }
+    }
+    os << '}';
+  }
+  os << '}';
+}
+
+inline void json_print(json_writer& json, const perf_totals& val)
+{
+  json.begin_object();
+  json.key("calls");
+  json.number(val.calls);
+  json.key("sum");
+  json_print(json, val.sum);
+  json.end_object();
+}
+
+} // namespace jdbg
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/pointer_trail.hpp>
+#include <jdbg/detail/stream.hpp>
 
 #include <cstddef>
-#include <iomanip>
-#include <ios>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -18,13 +18,13 @@
 namespace jdbg {
 
 template <typename T>
-void pretty_print(std::ostream& os, const T& val, std::true_type /*true*/)
+void pretty_print(ostream& os, const T& val, std::true_type /*true*/)
 {
   os << val;
 }
 
 template <typename T>
-void pretty_print(std::ostream& /*os*/, const T& /*val*/,
+void pretty_print(ostream& /*os*/, const T& /*val*/,
                   std::false_type /*false*/)
 {
   static_assert(detail::has_ostream_operator<T>::value,
@@ -35,107 +35,119 @@ void pretty_print(std::ostream& /*os*/, const T& /*val*/,
 
 template <typename T>
 std::enable_if_t<!detail::is_container<T>::value && !std::is_enum_v<T>, void>
-pretty_print(std::ostream& os, const T& val);
+pretty_print(ostream& os, const T& val);
 
-inline void pretty_print(std::ostream& os, const bool& val);
+inline void pretty_print(ostream& os, const bool& val);
 
-inline void pretty_print(std::ostream& os, const char& val);
+inline void pretty_print(ostream& os, const char& val);
 
 template <size_t N>
-void pretty_print(std::ostream& os, const char (&val)[N]);
+void pretty_print(ostream& os, const char (&val)[N]);
 
-inline void pretty_print(std::ostream& os, const char* const& val);
+inline void pretty_print(ostream& os, const char* const& val);
 
-inline void pretty_print(std::ostream& os, const std::string& val);
+inline void pretty_print(ostream& os, const std::string& val);
 
-inline void pretty_print(std::ostream& os, std::string_view val);
+inline void pretty_print(ostream& os, std::string_view val);
 
 template <typename P>
-void pretty_print(std::ostream& os, P* const& val);
+void pretty_print(ostream& os, P* const& val);
 
-inline void pretty_print(std::ostream& os, void* const& val);
+inline void pretty_print(ostream& os, void* const& val);
 
-inline void pretty_print(std::ostream& os, const void* const& val);
+inline void pretty_print(ostream& os, const void* const& val);
 
 template <typename T, typename Deleter>
-void pretty_print(std::ostream& os, const std::unique_ptr<T, Deleter>& val);
+void pretty_print(ostream& os, const std::unique_ptr<T, Deleter>& val);
 
 template <typename T>
-void pretty_print(std::ostream& os, const std::shared_ptr<T>& val);
+void pretty_print(ostream& os, const std::shared_ptr<T>& val);
 
 template <typename T1, typename T2>
-void pretty_print(std::ostream& os, const std::pair<T1, T2>& val);
+void pretty_print(ostream& os, const std::pair<T1, T2>& val);
 
 template <typename... Ts>
-void pretty_print(std::ostream& os, const std::tuple<Ts...>& val);
+void pretty_print(ostream& os, const std::tuple<Ts...>& val);
 
 template <typename E>
-std::enable_if_t<std::is_enum_v<E>, void> pretty_print(std::ostream& os,
+std::enable_if_t<std::is_enum_v<E>, void> pretty_print(ostream& os,
                                                        const E& val);
 
 template <typename Container>
 std::enable_if_t<detail::is_container<Container>::value, void>
-pretty_print(std::ostream& os, const Container& val);
+pretty_print(ostream& os, const Container& val);
 
 template <typename T>
-void pretty_print(std::ostream& os, const std::optional<T>& val);
+void pretty_print(ostream& os, const std::optional<T>& val);
 
 template <typename... Ts>
-void pretty_print(std::ostream& os, const std::variant<Ts...>& val);
+void pretty_print(ostream& os, const std::variant<Ts...>& val);
 
 ////////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
 std::enable_if_t<!detail::is_container<T>::value && !std::is_enum_v<T>, void>
-pretty_print(std::ostream& os, const T& val)
+pretty_print(ostream& os, const T& val)
 {
   pretty_print(os, val, detail::has_ostream_operator<T>{});
 }
 
-inline void pretty_print(std::ostream& os, const bool& val)
+inline void pretty_print(ostream& os, const bool& val)
 {
-  os << std::boolalpha << val;
+  os << (val ? "true" : "false");
 }
 
-inline void pretty_print(std::ostream& os, const char& val)
+inline void pretty_print(ostream& os, const char& val)
 {
-  os << "0x" << std::setw(2) << std::setfill('0') << std::hex
-     << std::nouppercase << (0xFF & val);
+  constexpr const char* digits = "0123456789abcdef";
+  const auto byte = static_cast<unsigned char>(val);
+  os << "0x" << digits[byte >> 4] << digits[byte & 0xF];
 }
 
 template <size_t N>
-void pretty_print(std::ostream& os, const char (&val)[N])
+void pretty_print(ostream& os, const char (&val)[N])
 {
   os << val;
 }
 
-inline void pretty_print(std::ostream& os, const char* const& val)
+inline void pretty_print(ostream& os, const char* const& val)
 {
   os << '"' << val << '"';
 }
 
-inline void pretty_print(std::ostream& os, const std::string& val)
+inline void pretty_print(ostream& os, const std::string& val)
 {
   os << '"' << val << '"';
 }
 
-inline void pretty_print(std::ostream& os, std::string_view val)
+inline void pretty_print(ostream& os, std::string_view val)
 {
   os << '"' << val << '"';
 }
 
 template <typename P>
-void pretty_print(std::ostream& os, P* const& val)
+void pretty_print(ostream& os, P* const& val)
 {
   if (val == nullptr) {
     os << "nullptr";
     return;
   }
-  os << val << " -> ";
+  const void* address = val;
+  if (detail::pointer_trail::contains(val)) {
+    os << "<cycle -> " << address << '>';
+    return;
+  }
+  os << address;
+  if (detail::pointer_trail::is_too_deep()) {
+    os << " -> ...";
+    return;
+  }
+  os << " -> ";
+  const detail::pointer_trail trail{val};
   pretty_print(os, *val);
 }
 
-inline void pretty_print(std::ostream& os, void* const& val)
+inline void pretty_print(ostream& os, void* const& val)
 {
   if (val == nullptr) {
     os << "nullptr";
@@ -144,7 +156,7 @@ inline void pretty_print(std::ostream& os, void* const& val)
   os << val;
 }
 
-inline void pretty_print(std::ostream& os, const void* const& val)
+inline void pretty_print(ostream& os, const void* const& val)
 {
   if (val == nullptr) {
     os << "nullptr";
@@ -154,20 +166,20 @@ inline void pretty_print(std::ostream& os, const void* const& val)
 }
 
 template <typename T, typename Deleter>
-void pretty_print(std::ostream& os, const std::unique_ptr<T, Deleter>& val)
+void pretty_print(ostream& os, const std::unique_ptr<T, Deleter>& val)
 {
   pretty_print(os, val.get());
 }
 
 template <typename T>
-void pretty_print(std::ostream& os, const std::shared_ptr<T>& val)
+void pretty_print(ostream& os, const std::shared_ptr<T>& val)
 {
   pretty_print(os, val.get());
   os << " (refs: " << val.use_count() << ")";
 }
 
 template <typename T1, typename T2>
-void pretty_print(std::ostream& os, const std::pair<T1, T2>& val)
+void pretty_print(ostream& os, const std::pair<T1, T2>& val)
 {
   os << '(';
   pretty_print(os, val.first);
@@ -179,7 +191,7 @@ void pretty_print(std::ostream& os, const std::pair<T1, T2>& val)
 namespace detail {
 
 template <typename Tuple, std::size_t... Is>
-void pretty_print_tuple(std::ostream& os, const Tuple& val,
+void pretty_print_tuple(ostream& os, const Tuple& val,
                         std::index_sequence<Is...> /*seq*/)
 {
   using swallow = int[];
@@ -191,7 +203,7 @@ void pretty_print_tuple(std::ostream& os, const Tuple& val,
 } // namespace detail
 
 template <typename... Ts>
-void pretty_print(std::ostream& os, const std::tuple<Ts...>& val)
+void pretty_print(ostream& os, const std::tuple<Ts...>& val)
 {
   os << '(';
   detail::pretty_print_tuple(os, val, std::index_sequence_for<Ts...>{});
@@ -199,7 +211,7 @@ void pretty_print(std::ostream& os, const std::tuple<Ts...>& val)
 }
 
 template <typename E>
-std::enable_if_t<std::is_enum_v<E>, void> pretty_print(std::ostream& os,
+std::enable_if_t<std::is_enum_v<E>, void> pretty_print(ostream& os,
                                                        const E& val)
 {
   os << static_cast<std::underlying_type_t<E>>(val);
@@ -207,7 +219,7 @@ std::enable_if_t<std::is_enum_v<E>, void> pretty_print(std::ostream& os,
 
 template <typename Container>
 std::enable_if_t<detail::is_container<Container>::value, void>
-pretty_print(std::ostream& os, const Container& val)
+pretty_print(ostream& os, const Container& val)
 {
   os << "[";
 
@@ -237,7 +249,7 @@ pretty_print(std::ostream& os, const Container& val)
 }
 
 template <typename T>
-void pretty_print(std::ostream& os, const std::optional<T>& val)
+void pretty_print(ostream& os, const std::optional<T>& val)
 {
   if (!val.has_value()) {
     os << "nullopt";
@@ -247,11 +259,22 @@ void pretty_print(std::ostream& os, const std::optional<T>& val)
 }
 
 template <typename... Ts>
-void pretty_print(std::ostream& os, const std::variant<Ts...>& val)
+void pretty_print(ostream& os, const std::variant<Ts...>& val)
 {
   os << '{';
   std::visit([&](auto&& arg) { pretty_print(os, arg); }, val);
   os << '}';
 }
 
+#ifdef JDBG_NO_IOSTREAM
+// Keeps user operator<< implementations calling pretty_print working
+template <typename T>
+void pretty_print(std::ostream& os, const T& val)
+{
+  detail::text_stream ts;
+  pretty_print(ts, val);
+  os << ts.str();
+}
+#endif
+
 } // namespace jdbg
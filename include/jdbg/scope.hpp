@@ -0,0 +1,436 @@
+#pragma once
+
+#include <jdbg/detail/io.hpp>
+#include <jdbg/detail/thread.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/mem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define JDBG_TRACE_TSC
+#endif
+
+namespace jdbg {
+
+// Timed spans recorded by dbg_scope() into per-thread buffers, written as a
+// Chrome trace event file (chrome://tracing, ui.perfetto.dev) at exit
+namespace detail::trace {
+
+// Static per dbg_scope() call site, spans only point to it
+struct site {
+  const char* name;
+  const char* file;
+  int line;
+  const char* func;
+};
+
+struct span {
+  const site* where;
+  std::int64_t begin;
+  std::int64_t end;
+  std::uint32_t depth;
+};
+
+constexpr std::size_t block_spans = 1024;
+
+// Spans beyond this per thread are counted as dropped instead of recorded
+constexpr std::size_t max_blocks = 1024;
+
+// Only the owning thread appends, size is published so the spans can be
+// read concurrently when the trace is written
+struct block {
+  span spans[block_spans];
+  std::atomic<std::size_t> size{0};
+  std::atomic<block*> next{nullptr};
+};
+
+inline std::int64_t steady_now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Spans are timed in TSC ticks where the TSC runs at a constant rate, as
+// reading it costs a fraction of a clock_gettime() call. Ticks are
+// converted to nanoseconds when the trace is written.
+inline bool use_tsc()
+{
+#if defined(JDBG_TRACE_TSC)
+  unsigned eax = 0;
+  unsigned ebx = 0;
+  unsigned ecx = 0;
+  unsigned edx = 0;
+  return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) != 0 &&
+         (edx & (1U << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+inline std::int64_t ticks(bool tsc)
+{
+#if defined(JDBG_TRACE_TSC)
+  if (tsc) {
+    return static_cast<std::int64_t>(__rdtsc());
+  }
+#endif
+  static_cast<void>(tsc);
+  return steady_now();
+}
+
+class thread_buffer {
+public:
+  thread_buffer(std::uint64_t tid, bool tsc, const std::atomic<bool>& closed)
+      : tid_{tid}, tsc_{tsc}, closed_{closed}
+  {
+  }
+
+  ~thread_buffer()
+  {
+    for (auto* blk = head_; blk != nullptr;) {
+      auto* next = blk->next.load(std::memory_order_relaxed);
+      delete blk;
+      blk = next;
+    }
+  }
+
+  thread_buffer(const thread_buffer&) = delete;
+  thread_buffer& operator=(const thread_buffer&) = delete;
+
+  std::int64_t now() const { return ticks(tsc_); }
+
+  std::uint32_t enter() { return depth_++; }
+
+  void leave(const span& val)
+  {
+    --depth_;
+    // The trace is being written at exit, later spans would be lost anyway
+    if (closed_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    auto size = tail_->size.load(std::memory_order_relaxed);
+    if (size == block_spans) {
+      if (blocks_ == max_blocks) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      grow();
+      size = 0;
+    }
+    tail_->spans[size] = val;
+    tail_->size.store(size + 1, std::memory_order_release);
+  }
+
+  std::uint64_t tid() const { return tid_; }
+
+  std::size_t dropped() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Calls fn for every span after the first skip ones, returns the total
+  template <typename Fn>
+  std::size_t for_each(std::size_t skip, Fn&& fn) const
+  {
+    std::size_t total = 0;
+    for (const auto* blk = head_; blk != nullptr;
+         blk = blk->next.load(std::memory_order_acquire)) {
+      const auto size = blk->size.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < size; ++i, ++total) {
+        if (total >= skip) {
+          fn(blk->spans[i]);
+        }
+      }
+    }
+    return total;
+  }
+
+private:
+  void grow()
+  {
+    const mem::pause no_count;
+    auto* blk = new block;
+    tail_->next.store(blk, std::memory_order_release);
+    tail_ = blk;
+    ++blocks_;
+  }
+
+private:
+  std::uint64_t tid_;
+  bool tsc_;
+  const std::atomic<bool>& closed_;
+  std::uint32_t depth_{0};
+  block* head_{new block};
+  block* tail_{head_};
+  std::size_t blocks_{1};
+  std::atomic<std::size_t> dropped_{0};
+};
+
+// Owns the buffers of all threads, so spans outlive the threads recording
+// them. Spans not written yet go to the trace file at exit.
+class registry {
+public:
+  // Never destroyed, as threads still running at exit may record spans
+  // into their buffers. The trace is written by closer at exit instead.
+  static registry& instance(const char* path = nullptr)
+  {
+    static registry* const reg = [path] {
+      const mem::pause no_count;
+      return new registry{path};
+    }();
+    static const closer at_exit{*reg};
+    return *reg;
+  }
+
+  explicit registry(const char* path)
+      : tsc_{use_tsc()}, origin_{ticks(tsc_)}, origin_ns_{steady_now()}
+  {
+    if (path != nullptr && *path != '\0') {
+      path_ = path;
+    } else {
+      path_ = "jdbg-";
+      writer{path_}.write_integer(::getpid());
+      path_ += ".trace.json";
+    }
+  }
+
+  ~registry() { close(); }
+
+  registry(const registry&) = delete;
+  registry& operator=(const registry&) = delete;
+
+  thread_buffer* add()
+  {
+    const mem::pause no_count;
+    const std::lock_guard<std::mutex> lock{mutex_};
+    buffers_.push_back(
+        {std::make_unique<thread_buffer>(thread_id(), tsc_, closed_), 0});
+    return buffers_.back().buffer.get();
+  }
+
+  // Writes the spans recorded since the previous write, returns 0 or the
+  // errno of the failed open or write
+  int write(const char* path)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return write_locked(path, false);
+  }
+
+  // Stops recording and writes what is left to the trace file. Should the
+  // program have written that file itself, it is rewritten with every span
+  // instead, so that those it held are kept.
+  void close()
+  {
+    if (closed_.exchange(true)) {
+      return;
+    }
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (pending_locked()) {
+      const bool rewrite = std::find(written_.begin(), written_.end(),
+                                     path_) != written_.end();
+      write_locked(path_.c_str(), rewrite);
+    }
+  }
+
+  const std::string& path() const { return path_; }
+
+private:
+  static constexpr std::size_t flush_size = 1 << 20;
+
+  struct entry {
+    std::unique_ptr<thread_buffer> buffer;
+    std::size_t written;
+  };
+
+  struct closer {
+    registry& reg;
+    ~closer() { reg.close(); }
+  };
+
+  // Writes the spans since the previous write, or all of them
+  int write_locked(const char* path, bool all)
+  {
+    {
+      const mem::pause no_count;
+      if (std::find(written_.begin(), written_.end(), path) ==
+          written_.end()) {
+        written_.emplace_back(path);
+      }
+    }
+    const int fd =
+        ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return errno;
+    }
+
+    const auto pid = ::getpid();
+    const auto elapsed = ticks(tsc_) - origin_;
+    const double ns_per_tick =
+        tsc_ && elapsed > 0
+            ? static_cast<double>(steady_now() - origin_ns_) / elapsed
+            : 1.0;
+    std::string out;
+    int error = 0;
+    std::size_t dropped = 0;
+    json_writer json{out};
+    json.begin_object();
+    json.key("traceEvents");
+    json.begin_array();
+    for (auto& entry : buffers_) {
+      const auto tid = entry.buffer->tid();
+      const auto skip = all ? 0 : entry.written;
+      entry.written = entry.buffer->for_each(skip, [&](const span& s) {
+        print_span(json, s, ns_per_tick, pid, tid);
+        if (out.size() >= flush_size && error == 0) {
+          error = flush(fd, out);
+        }
+      });
+      dropped += entry.buffer->dropped();
+    }
+    json.end_array();
+    json.key("displayTimeUnit");
+    json.string("ns");
+    json.key("otherData");
+    json.begin_object();
+    json.key("dropped");
+    json.number(dropped);
+    json.end_object();
+    json.end_object();
+    out += '\n';
+
+    if (error == 0) {
+      error = flush(fd, out);
+    }
+    if (::close(fd) != 0 && error == 0) {
+      error = errno;
+    }
+    return error;
+  }
+
+  bool pending_locked() const
+  {
+    for (const auto& entry : buffers_) {
+      if (entry.buffer->for_each(entry.written, [](const span&) {}) !=
+          entry.written) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static int flush(int fd, std::string& out)
+  {
+    iovec iov{out.data(), out.size()};
+    const int error = writev_all(fd, &iov, 1);
+    out.clear();
+    return error;
+  }
+
+  // Complete ("X") events, timestamps in microseconds since the first span
+  void print_span(json_writer& json, const span& s, double ns_per_tick,
+                  int pid, std::uint64_t tid) const
+  {
+    json.begin_object();
+    json.key("name");
+    json.string(s.where->name);
+    json.key("cat");
+    json.string("jdbg");
+    json.key("ph");
+    json.string("X");
+    json.key("ts");
+    json.number(static_cast<double>(s.begin - origin_) * ns_per_tick / 1000);
+    json.key("dur");
+    json.number(static_cast<double>(s.end - s.begin) * ns_per_tick / 1000);
+    json.key("pid");
+    json.number(pid);
+    json.key("tid");
+    json.number(tid);
+    json.key("args");
+    json.begin_object();
+    json.key("file");
+    json.string(s.where->file);
+    json.key("line");
+    json.number(s.where->line);
+    json.key("func");
+    json.string(s.where->func);
+    json.key("depth");
+    json.number(s.depth);
+    json.end_object();
+    json.end_object();
+  }
+
+private:
+  std::mutex mutex_;
+  std::string path_;
+  bool tsc_;
+  std::int64_t origin_;
+  std::int64_t origin_ns_;
+  std::vector<entry> buffers_;
+  std::vector<std::string> written_; // paths written so far
+  std::atomic<bool> closed_{false};
+};
+
+inline thread_buffer& local_buffer(const char* path)
+{
+  thread_local thread_buffer* const buffer = registry::instance(path).add();
+  return *buffer;
+}
+
+// Records the time from construction to destruction as one span
+class scope {
+public:
+  scope(const site& where, thread_buffer& buffer)
+      : buffer_{buffer},
+        where_{&where},
+        depth_{buffer.enter()},
+        begin_{buffer.now()}
+  {
+  }
+
+  ~scope()
+  {
+    const auto end = buffer_.now();
+    buffer_.leave({where_, begin_, end, depth_});
+  }
+
+  scope(const scope&) = delete;
+  scope& operator=(const scope&) = delete;
+
+private:
+  thread_buffer& buffer_;
+  const site* where_;
+  std::uint32_t depth_;
+  std::int64_t begin_;
+};
+
+} // namespace detail::trace
+
+// Writes the spans recorded since the previous write to path instead of
+// leaving them for the trace file written at exit
+inline int write_trace(const char* path)
+{
+  return detail::trace::registry::instance().write(path);
+}
+
+} // namespace jdbg
+
+#undef JDBG_TRACE_TSC
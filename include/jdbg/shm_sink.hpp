@@ -0,0 +1,601 @@
+#pragma once
+
+#include <jdbg/json_print.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Log sink for servers forking worker processes, e.g.
+//
+//   jdbg::shm_sink jdbg_sink{"/myserver-jdbg"};
+//   #define JDBG_LOG_FUNCTION(str) jdbg_sink.write(str)
+//   #include <jdbg/jdbg.hpp>
+//
+// Each process appends its records to a ring of its own inside one POSIX
+// shared memory segment, so workers do not contend on a common stderr. A
+// process forked after the sink was created claims a new ring in the child.
+// Writers never wait for the reader: a record not fitting into the ring is
+// dropped and counted. The rings outlive the processes writing them, so
+// "jdbg-tool collect <name>" prints records of crashed workers too, merged
+// by time and tagged with the pid of their writer.
+//
+// Whoever opens the segment first creates it with its ring count and size,
+// everybody else uses those. The segment stays until removed with
+// shm_sink::remove() or rm /dev/shm/<name>.
+
+namespace jdbg {
+namespace detail::shm {
+
+constexpr std::uint32_t magic = 0x4a444753; // "JDGS"
+constexpr std::uint32_t version = 1;
+constexpr std::size_t cache_line = 64;
+constexpr std::size_t max_rings = 4096;
+constexpr std::size_t min_ring_size = 4096;
+
+// Records are 8 byte aligned and start with
+//   u32 length | pad_flag, u32 text size, u64 time
+// The length is stored last, a ring position holding 0 is not written yet.
+// Pad records fill the end of the ring when a record does not fit there.
+constexpr std::size_t record_header_size = 16;
+constexpr std::uint32_t pad_flag = 1U << 31;
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                  std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared memory rings need lock-free atomics");
+
+struct segment_header {
+  std::atomic<std::uint32_t> ready; // magic once the rings are set up
+  std::uint32_t version;
+  std::uint32_t rings;
+  std::uint32_t ring_size;
+};
+
+// Writers and the reader update their positions on separate cache lines
+struct ring_header {
+  alignas(cache_line) std::atomic<std::int32_t> pid; // 0 when free
+  std::atomic<std::uint64_t> dropped;
+  alignas(cache_line) std::atomic<std::uint64_t> reserved;
+  alignas(cache_line) std::atomic<std::uint64_t> consumed;
+};
+
+inline std::uint64_t now()
+{
+  timespec ts{};
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000U +
+         static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+inline std::atomic<std::uint32_t>& length_of(char* record)
+{
+  return *reinterpret_cast<std::atomic<std::uint32_t>*>(record);
+}
+
+// Owner of a ring being freed by the reader
+constexpr std::int32_t freeing = -1;
+
+inline bool is_alive(std::int32_t pid)
+{
+  return pid <= 0 || ::kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Many writers of one process, one reader. Writers reserve space with a
+// CAS and never wait for the reader, which zeroes what it has read before
+// handing the space back.
+class ring {
+public:
+  ring(ring_header& head, char* data, std::size_t size)
+      : head_{&head}, data_{data}, mask_{size - 1}
+  {
+  }
+
+  ring_header& head() const { return *head_; }
+
+  std::size_t size() const { return mask_ + 1; }
+
+  // False when the ring has no room for the record
+  bool push(std::uint64_t time, std::string_view text)
+  {
+    const auto length = (record_header_size + text.size() + 7) & ~7ULL;
+    if (length > size() / 4) {
+      return false;
+    }
+
+    auto pos = head_->reserved.load(std::memory_order_relaxed);
+    std::uint64_t skip = 0;
+    do {
+      const auto rest = size() - (pos & mask_);
+      skip = rest < length ? rest : 0;
+      // Acquire: the space must be zeroed before it is written again
+      if (pos + skip + length -
+              head_->consumed.load(std::memory_order_acquire) >
+          size()) {
+        return false;
+      }
+    } while (!head_->reserved.compare_exchange_weak(
+        pos, pos + skip + length, std::memory_order_relaxed));
+
+    if (skip != 0) {
+      length_of(data_ + (pos & mask_))
+          .store(pad_flag | static_cast<std::uint32_t>(skip),
+                 std::memory_order_release);
+      pos += skip;
+    }
+    auto* record = data_ + (pos & mask_);
+    const auto text_size = static_cast<std::uint32_t>(text.size());
+    std::memcpy(record + 4, &text_size, sizeof(text_size));
+    std::memcpy(record + 8, &time, sizeof(time));
+    std::memcpy(record + record_header_size, text.data(), text.size());
+    length_of(record).store(static_cast<std::uint32_t>(length),
+                            std::memory_order_release);
+    return true;
+  }
+
+  // Calls fn(time, text) for the records written completely so far, in
+  // ring order, stopping at the first one still being written
+  template <typename Fn>
+  std::size_t drain(Fn&& fn)
+  {
+    auto pos = head_->consumed.load(std::memory_order_relaxed);
+    const auto end = head_->reserved.load(std::memory_order_acquire);
+    std::size_t count = 0;
+    while (pos < end) {
+      auto* record = data_ + (pos & mask_);
+      const auto word = length_of(record).load(std::memory_order_acquire);
+      if (word == 0) {
+        break;
+      }
+      const auto length = word & ~pad_flag;
+      std::uint32_t text_size = 0;
+      std::memcpy(&text_size, record + 4, sizeof(text_size));
+      if (length == 0 || length % 8 != 0 ||
+          length > size() - (pos & mask_) ||
+          ((word & pad_flag) == 0 &&
+           record_header_size + text_size > length)) {
+        // Not written by a sink, nothing after it can be trusted
+        head_->consumed.store(pos, std::memory_order_release);
+        discard();
+        return count;
+      }
+      if ((word & pad_flag) == 0) {
+        std::uint64_t time = 0;
+        std::memcpy(&time, record + 8, sizeof(time));
+        fn(time, std::string_view{record + record_header_size, text_size});
+        ++count;
+      }
+      std::memset(record, 0, length);
+      pos += length;
+    }
+    head_->consumed.store(pos, std::memory_order_release);
+    return count;
+  }
+
+  // Drops everything reserved but not read, only safe when no process is
+  // writing anymore, returns the bytes dropped
+  std::uint64_t discard()
+  {
+    auto pos = head_->consumed.load(std::memory_order_relaxed);
+    const auto end = head_->reserved.load(std::memory_order_acquire);
+    const auto bytes = end - pos;
+    while (pos < end) {
+      const auto offset = pos & mask_;
+      const auto chunk = std::min<std::uint64_t>(end - pos, size() - offset);
+      std::memset(data_ + offset, 0, chunk);
+      pos += chunk;
+    }
+    head_->consumed.store(end, std::memory_order_release);
+    return bytes;
+  }
+
+  bool is_empty() const
+  {
+    return head_->consumed.load(std::memory_order_acquire) ==
+           head_->reserved.load(std::memory_order_acquire);
+  }
+
+private:
+  ring_header* head_;
+  char* data_;
+  std::size_t mask_;
+};
+
+constexpr std::size_t ring_stride(std::size_t ring_size)
+{
+  return sizeof(ring_header) + ring_size;
+}
+
+constexpr std::size_t segment_size(std::size_t rings, std::size_t ring_size)
+{
+  return cache_line + rings * ring_stride(ring_size);
+}
+
+// The mapped segment, opened or created on construction
+class segment {
+public:
+  segment(const char* name, std::size_t rings, std::size_t ring_size)
+  {
+    std::size_t size = min_ring_size;
+    while (size < ring_size && size < (std::size_t{1} << 30)) {
+      size *= 2;
+    }
+    rings = std::min(std::max<std::size_t>(rings, 1), max_rings);
+
+    const int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+      create(fd, rings, size);
+    } else if (errno == EEXIST) {
+      open(::shm_open(name, O_RDWR, 0));
+    } else {
+      error_ = errno;
+    }
+  }
+
+  ~segment()
+  {
+    if (addr_ != nullptr) {
+      ::munmap(addr_, size_);
+    }
+  }
+
+  segment(const segment&) = delete;
+  segment& operator=(const segment&) = delete;
+
+  bool is_open() const { return addr_ != nullptr; }
+
+  int error() const { return error_; }
+
+  std::size_t rings() const { return is_open() ? header().rings : 0; }
+
+  ring at(std::size_t index) const
+  {
+    auto* base = static_cast<char*>(addr_) + cache_line +
+                 index * ring_stride(header().ring_size);
+    return {*reinterpret_cast<ring_header*>(base), base + sizeof(ring_header),
+            header().ring_size};
+  }
+
+private:
+  segment_header& header() const
+  {
+    return *static_cast<segment_header*>(addr_);
+  }
+
+  void create(int fd, std::size_t rings, std::size_t ring_size)
+  {
+    const auto size = segment_size(rings, ring_size);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(fd, size)) {
+      error_ = errno;
+      ::close(fd);
+      return;
+    }
+    ::close(fd);
+
+    auto* head = new (addr_) segment_header{};
+    head->version = version;
+    head->rings = static_cast<std::uint32_t>(rings);
+    head->ring_size = static_cast<std::uint32_t>(ring_size);
+    for (std::size_t i = 0; i < rings; ++i) {
+      new (static_cast<char*>(addr_) + cache_line + i * ring_stride(ring_size))
+          ring_header{};
+    }
+    head->ready.store(magic, std::memory_order_release);
+  }
+
+  // Waits a little for a creator running concurrently to set it up
+  void open(int fd)
+  {
+    if (fd < 0) {
+      error_ = errno;
+      return;
+    }
+    error_ = ETIMEDOUT;
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        error_ = errno;
+        break;
+      }
+      const auto size = static_cast<std::size_t>(st.st_size);
+      if (size >= cache_line && map(fd, size)) {
+        const auto& head = header();
+        if (head.ready.load(std::memory_order_acquire) == magic) {
+          error_ = 0;
+          if (head.version != version || head.ring_size < min_ring_size ||
+              (head.ring_size & (head.ring_size - 1)) != 0 ||
+              size < segment_size(head.rings, head.ring_size)) {
+            error_ = EINVAL;
+            ::munmap(addr_, size_);
+            addr_ = nullptr;
+          }
+          ::close(fd);
+          return;
+        }
+        ::munmap(addr_, size_);
+        addr_ = nullptr;
+      }
+      ::usleep(1000);
+    }
+    ::close(fd);
+  }
+
+  bool map(int fd, std::size_t size)
+  {
+    void* addr =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    addr_ = addr;
+    size_ = size;
+    return true;
+  }
+
+private:
+  void* addr_{nullptr};
+  std::size_t size_{0};
+  int error_{0};
+};
+
+} // namespace detail::shm
+
+class shm_sink;
+
+namespace detail::shm {
+
+// The sinks of the process, given new rings in the child after fork()
+class forked_sinks {
+public:
+  static forked_sinks& instance()
+  {
+    static forked_sinks sinks;
+    return sinks;
+  }
+
+  void add(shm_sink* sink)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    sinks_.push_back(sink);
+  }
+
+  void remove(shm_sink* sink)
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (auto& entry : sinks_) {
+      if (entry == sink) {
+        entry = sinks_.back();
+        sinks_.pop_back();
+        break;
+      }
+    }
+  }
+
+private:
+  forked_sinks() { ::pthread_atfork(&prepare, &parent, &child); }
+
+  static void prepare() { instance().mutex_.lock(); }
+
+  static void parent() { instance().mutex_.unlock(); }
+
+  static void child();
+
+private:
+  std::mutex mutex_;
+  std::vector<shm_sink*> sinks_;
+};
+
+} // namespace detail::shm
+
+class shm_sink {
+public:
+  explicit shm_sink(const char* name, std::size_t rings = 64,
+                    std::size_t ring_size = 256 * 1024)
+      : segment_{name, rings, ring_size}
+  {
+    attach();
+    detail::shm::forked_sinks::instance().add(this);
+  }
+
+  // The ring stays claimed until the reader has emptied it after the
+  // process exited
+  ~shm_sink() { detail::shm::forked_sinks::instance().remove(this); }
+
+  shm_sink(const shm_sink&) = delete;
+  shm_sink& operator=(const shm_sink&) = delete;
+
+  bool is_open() const { return ring_.has_value(); }
+
+  // errno of opening the segment, 0 when open
+  int error() const { return segment_.error(); }
+
+  void write(std::string_view record)
+  {
+    if (!ring_ || !ring_->push(detail::shm::now(), record)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      if (ring_) {
+        ring_->head().dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Records of this process not written since the sink was created
+  std::uint64_t dropped() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Claims a free ring for the calling process, done on construction and
+  // in the child after fork(). Rings of exited processes can be taken over
+  // once they are empty.
+  void attach()
+  {
+    ring_.reset();
+    dropped_.store(0, std::memory_order_relaxed);
+    const auto self = static_cast<std::int32_t>(::getpid());
+    for (std::size_t i = 0; i < segment_.rings(); ++i) {
+      auto candidate = segment_.at(i);
+      auto& pid = candidate.head().pid;
+      auto owner = pid.load(std::memory_order_acquire);
+      if (owner == detail::shm::freeing) {
+        continue;
+      }
+      if (owner != 0 &&
+          (detail::shm::is_alive(owner) || !candidate.is_empty())) {
+        continue;
+      }
+      if (pid.compare_exchange_strong(owner, self,
+                                      std::memory_order_acq_rel)) {
+        candidate.head().dropped.store(0, std::memory_order_relaxed);
+        ring_.emplace(candidate);
+        return;
+      }
+    }
+  }
+
+  static int remove(const char* name)
+  {
+    return ::shm_unlink(name) == 0 ? 0 : errno;
+  }
+
+private:
+  detail::shm::segment segment_;
+  std::optional<detail::shm::ring> ring_;
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+inline void detail::shm::forked_sinks::child()
+{
+  auto& sinks = instance();
+  for (auto* sink : sinks.sinks_) {
+    sink->attach();
+  }
+  sinks.mutex_.unlock();
+}
+
+// A record read back from the rings
+struct shm_record {
+  std::int32_t pid{0};
+  std::uint64_t time{0}; // CLOCK_MONOTONIC nanoseconds
+  std::string text;
+  bool is_note{false}; // plain text from the collector, not from a sink
+};
+
+// {"pid":..,"time":..,"record":..} with the record as written when the
+// sinks wrote JSON objects, as a JSON string otherwise, or {.."note":".."}
+// for collector notes
+inline void json_print(json_writer& json, const shm_record& val)
+{
+  json.begin_object();
+  json.key("pid");
+  json.number(val.pid);
+  json.key("time");
+  json.number(val.time);
+  if (val.is_note) {
+    json.key("note");
+    json.string(val.text);
+  } else if (detail::is_json_object(val.text)) {
+    json.key("record");
+    json.raw(val.text);
+  } else {
+    json.key("record");
+    json.string(val.text);
+  }
+  json.end_object();
+}
+
+// Reads the rings of a segment, meant to be the only reader
+class shm_collector {
+public:
+  explicit shm_collector(const char* name, std::size_t rings = 64,
+                         std::size_t ring_size = 256 * 1024)
+      : segment_{name, rings, ring_size},
+        owners_(segment_.rings(), 0),
+        reported_(segment_.rings(), 0)
+  {
+  }
+
+  bool is_open() const { return segment_.is_open(); }
+
+  int error() const { return segment_.error(); }
+
+  // Appends the records written completely since the last call to out, in
+  // ring order. Rings of exited processes are freed once read, dropping
+  // records they were still writing when they died. Drops are reported as
+  // records of the process they happened in.
+  std::size_t drain(std::vector<shm_record>& out)
+  {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < segment_.rings(); ++i) {
+      auto ring = segment_.at(i);
+      auto& head = ring.head();
+      auto pid = head.pid.load(std::memory_order_acquire);
+      if (pid <= 0) {
+        continue;
+      }
+      if (pid != owners_[i]) {
+        owners_[i] = pid;
+        reported_[i] = 0;
+      }
+      // Checked first, whatever it wrote before exiting is read below
+      const bool exited = !detail::shm::is_alive(pid);
+      count += ring.drain([&](std::uint64_t time, std::string_view text) {
+        out.push_back({pid, time, std::string{text}});
+      });
+
+      const auto dropped = head.dropped.load(std::memory_order_relaxed);
+      if (dropped > reported_[i]) {
+        out.push_back({pid, detail::shm::now(),
+                       note(dropped - reported_[i], " records dropped"),
+                       true});
+        ++count;
+      }
+      reported_[i] = dropped;
+
+      // Unless a new process took the ring over in the meantime
+      if (exited && head.pid.compare_exchange_strong(
+                        pid, detail::shm::freeing, std::memory_order_acq_rel)) {
+        const auto bytes = ring.discard();
+        if (bytes != 0) {
+          out.push_back({owners_[i], detail::shm::now(),
+                         note(bytes, " bytes of unfinished records dropped"),
+                         true});
+          ++count;
+        }
+        owners_[i] = 0;
+        head.dropped.store(0, std::memory_order_relaxed);
+        head.pid.store(0, std::memory_order_release);
+      }
+    }
+    return count;
+  }
+
+private:
+  static std::string note(std::uint64_t count, const char* what)
+  {
+    return "jdbg: " + std::to_string(count) + what;
+  }
+
+private:
+  detail::shm::segment segment_;
+  std::vector<std::int32_t> owners_;
+  std::vector<std::uint64_t> reported_;
+};
+
+} // namespace jdbg
@@ -0,0 +1,391 @@
+#pragma once
+
+#include <jdbg/detail/io.hpp>
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+#include <jdbg/type_name.hpp> // NOLINT
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace jdbg {
+
+// Raw copies of contiguous ranges of trivially copyable elements, appended
+// to a side file, e.g.
+//
+//   const auto ref = jdbg::snapshot(samples);
+//
+// The file starts with the 8 byte magic "JDBGSNP\n" padded to 64 bytes.
+// Each snapshot then has a header, all integers little endian:
+//
+//   "SNAP", u32 header size, u64 count, u32 element size,
+//   u8 byte order (0 little, 1 big endian), 3 zero bytes,
+//   u32 type name size, type name, zero padding
+//
+// followed by the elements in the byte order of the writer. Headers and data
+// are padded to 64 bytes, so a mapped file can be used in place. Use
+// snapshot_reader or "jdbg-tool snapshot" to read it back.
+namespace detail::snapshot {
+
+constexpr std::string_view magic{"JDBGSNP\n"};
+constexpr std::string_view record_magic{"SNAP"};
+constexpr std::size_t alignment = 64;
+constexpr std::size_t fixed_header_size = 28;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr std::uint8_t native_byte_order = 1;
+#else
+constexpr std::uint8_t native_byte_order = 0;
+#endif
+
+constexpr std::size_t padding(std::size_t size)
+{
+  return (alignment - size % alignment) % alignment;
+}
+
+inline void put(std::string& out, std::uint64_t val, int bytes)
+{
+  for (int i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>((val >> (8 * i)) & 0xFF));
+  }
+}
+
+inline std::uint64_t get(const char* ptr, int bytes)
+{
+  std::uint64_t val = 0;
+  for (int i = bytes - 1; i >= 0; --i) {
+    val = (val << 8) | static_cast<unsigned char>(ptr[i]);
+  }
+  return val;
+}
+
+inline std::string header(std::string_view type, std::size_t element_size,
+                          std::size_t count)
+{
+  std::string out{record_magic};
+  const auto size = fixed_header_size + type.size();
+  put(out, size + padding(size), 4);
+  put(out, count, 8);
+  put(out, element_size, 4);
+  put(out, native_byte_order, 1);
+  put(out, 0, 3);
+  put(out, type.size(), 4);
+  out += type;
+  out.append(padding(size), '\0');
+  return out;
+}
+
+} // namespace detail::snapshot
+
+// Where a snapshot went, printed by dbg_snapshot() instead of the elements
+struct snapshot_ref {
+  std::string path;
+  std::uint64_t offset{0};
+  std::string type; // of the elements
+  std::size_t element_size{0};
+  std::size_t count{0};
+  int error{0}; // errno of the failed open or write, 0 on success
+};
+
+// The side file of the process, created on first use. Without a path it is
+// named after the process, jdbg-<pid>.snap in the working directory.
+class snapshot_file {
+public:
+  static snapshot_file& instance(const char* path = nullptr)
+  {
+    static snapshot_file file{path};
+    return file;
+  }
+
+  explicit snapshot_file(const char* path)
+  {
+    if (path != nullptr && *path != '\0') {
+      path_ = path;
+    } else {
+      path_ = "jdbg-";
+      detail::writer{path_}.write_integer(::getpid());
+      path_ += ".snap";
+    }
+  }
+
+  ~snapshot_file()
+  {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  snapshot_file(const snapshot_file&) = delete;
+  snapshot_file& operator=(const snapshot_file&) = delete;
+
+  const std::string& path() const { return path_; }
+
+  // The elements are written straight from where they are, without a copy
+  snapshot_ref append(std::string_view type, std::size_t element_size,
+                      std::size_t count, const void* data)
+  {
+    using namespace detail::snapshot;
+
+    snapshot_ref ref{path_, 0, std::string{type}, element_size, count, 0};
+    auto head = header(type, element_size, count);
+    const auto bytes = element_size * count;
+    static const char zeros[alignment] = {};
+
+    iovec iov[3] = {{head.data(), head.size()},
+                    {const_cast<void*>(data), bytes}, // NOLINT
+                    {const_cast<char*>(zeros), padding(bytes)}}; // NOLINT
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (!open_locked(ref.error)) {
+      return ref;
+    }
+    ref.offset = offset_;
+    ref.error = detail::writev_all(fd_, iov, 3);
+    if (ref.error == 0) {
+      offset_ += head.size() + bytes + padding(bytes);
+    } else {
+      // Later snapshots must not follow a partial one
+      ::close(fd_);
+      fd_ = -1;
+      failed_ = ref.error;
+    }
+    return ref;
+  }
+
+private:
+  bool open_locked(int& error)
+  {
+    using namespace detail::snapshot;
+
+    if (fd_ >= 0) {
+      return true;
+    }
+    if (failed_ != 0) {
+      error = failed_;
+      return false;
+    }
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                 0644);
+    if (fd_ < 0) {
+      error = failed_ = errno;
+      return false;
+    }
+    std::string head{magic};
+    head.append(padding(head.size()), '\0');
+    iovec iov{head.data(), head.size()};
+    error = detail::writev_all(fd_, &iov, 1);
+    if (error != 0) {
+      ::close(fd_);
+      fd_ = -1;
+      failed_ = error;
+      return false;
+    }
+    offset_ = head.size();
+    return true;
+  }
+
+private:
+  std::mutex mutex_;
+  std::string path_;
+  int fd_{-1};
+  int failed_{0};
+  std::uint64_t offset_{0};
+};
+
+// Any contiguous range with std::data(), e.g. std::vector, std::array,
+// std::span and C arrays. path only matters for the first snapshot of the
+// process, as there is a single side file.
+template <typename Range>
+snapshot_ref snapshot(const Range& range, const char* path = nullptr)
+{
+  using T =
+      std::remove_cv_t<std::remove_pointer_t<decltype(std::data(range))>>;
+  static_assert(std::is_trivially_copyable_v<T>,
+                "snapshot() needs trivially copyable elements");
+
+  static const std::string type = get_type_name<T>();
+  return snapshot_file::instance(path).append(
+      type, sizeof(T), static_cast<std::size_t>(detail::size(range)),
+      std::data(range));
+}
+
+// One snapshot inside a file read by snapshot_reader, pointing into it
+struct snapshot_view {
+  std::uint64_t offset{0};
+  std::string_view type;
+  std::size_t element_size{0};
+  std::size_t count{0};
+  bool little_endian{true};
+  const void* data{nullptr};
+
+  std::size_t bytes() const { return element_size * count; }
+
+  bool is_native() const
+  {
+    return little_endian == (detail::snapshot::native_byte_order == 0);
+  }
+
+  // The elements in place, nullptr unless they were written as T by a
+  // process of the same byte order
+  template <typename T>
+  const T* as() const
+  {
+    if (sizeof(T) != element_size || !is_native() ||
+        type != get_type_name<T>() ||
+        reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) {
+      return nullptr;
+    }
+    return static_cast<const T*>(data);
+  }
+};
+
+// Reads snapshots from a whole file, typically mapped into memory
+class snapshot_reader {
+public:
+  enum class status { ok, end, truncated, corrupt };
+
+  explicit snapshot_reader(std::string_view data) : data_{data}
+  {
+    using detail::snapshot::magic;
+
+    if (data_.substr(0, magic.size()) != magic) {
+      status_ = data_.size() < magic.size() &&
+                        magic.substr(0, data_.size()) == data_
+                    ? status::truncated
+                    : status::corrupt;
+      return;
+    }
+    pos_ = magic.size() + detail::snapshot::padding(magic.size());
+  }
+
+  // The next snapshot in file order, false once there is none left
+  bool next(snapshot_view& out)
+  {
+    if (status_ != status::ok) {
+      return false;
+    }
+    if (pos_ >= data_.size()) {
+      status_ = status::end;
+      return false;
+    }
+    status_ = read(pos_, out);
+    if (status_ != status::ok) {
+      return false;
+    }
+    pos_ = end_of(out);
+    return true;
+  }
+
+  // The snapshot at an offset printed by dbg_snapshot()
+  status at(std::uint64_t offset, snapshot_view& out) const
+  {
+    if (status_ != status::ok && status_ != status::end) {
+      return status_;
+    }
+    return read(offset, out);
+  }
+
+  status state() const { return status_; }
+
+private:
+  status read(std::uint64_t offset, snapshot_view& out) const
+  {
+    using namespace detail::snapshot;
+
+    if (offset >= data_.size()) {
+      return status::corrupt;
+    }
+    const auto rest = data_.substr(static_cast<std::size_t>(offset));
+    if (rest.size() < fixed_header_size) {
+      return record_magic.substr(0, rest.size()) ==
+                     rest.substr(0, record_magic.size())
+                 ? status::truncated
+                 : status::corrupt;
+    }
+    const auto* ptr = rest.data();
+    const auto header_size = get(ptr + 4, 4);
+    const auto count = get(ptr + 8, 8);
+    const auto element_size = get(ptr + 16, 4);
+    const auto order = get(ptr + 20, 1);
+    const auto type_size = get(ptr + 24, 4);
+    if (rest.substr(0, record_magic.size()) != record_magic ||
+        header_size % alignment != 0 ||
+        header_size < fixed_header_size + type_size || order > 1 ||
+        (element_size != 0 &&
+         count > std::numeric_limits<std::size_t>::max() / element_size)) {
+      return status::corrupt;
+    }
+    if (rest.size() < header_size ||
+        rest.size() - header_size < count * element_size) {
+      return status::truncated;
+    }
+
+    out.offset = offset;
+    out.type = rest.substr(fixed_header_size, type_size);
+    out.element_size = element_size;
+    out.count = count;
+    out.little_endian = order == 0;
+    out.data = ptr + header_size;
+    return status::ok;
+  }
+
+  std::size_t end_of(const snapshot_view& view) const
+  {
+    const auto end = static_cast<std::size_t>(
+        static_cast<const char*>(view.data) - data_.data()) + view.bytes();
+    return end + detail::snapshot::padding(end);
+  }
+
+private:
+  std::string_view data_;
+  std::size_t pos_{0};
+  status status_{status::ok};
+};
+
+inline void pretty_print(ostream& os, const snapshot_ref& val)
+{
+  if (val.error != 0) {
+    os << "cannot snapshot to " << val.path << ": "
+       << std::strerror(val.error);
+    return;
+  }
+  os << "snapshot " << val.path << '@' << val.offset << " (" << val.count
+     << " x " << val.type << ')';
+}
+
+inline void json_print(json_writer& json, const snapshot_ref& val)
+{
+  json.begin_object();
+  json.key("file");
+  json.string(val.path);
+  if (val.error != 0) {
+    json.key("error");
+    json.string(std::strerror(val.error));
+  } else {
+    json.key("offset");
+    json.number(val.offset);
+    json.key("element_type");
+    json.string(val.type);
+    json.key("element_size");
+    json.number(val.element_size);
+    json.key("count");
+    json.number(val.count);
+  }
+  json.end_object();
+}
+
+} // namespace jdbg
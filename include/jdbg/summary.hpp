@@ -0,0 +1,304 @@
+#pragma once
+
+#include <jdbg/detail/meta.hpp>
+#include <jdbg/detail/stream.hpp>
+#include <jdbg/json_print.hpp>
+#include <jdbg/pretty_print.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+namespace jdbg {
+
+// One pass statistics over a contiguous range of numbers. NaNs are counted
+// but left out of min, max, sum and mean. sorted has std::is_sorted()
+// semantics, so NaNs do not make a range unsorted.
+template <typename T>
+struct numeric_summary {
+  std::size_t size{0};
+  T min{};
+  T max{};
+  double sum{0};
+  std::size_t nan{0};
+  std::size_t inf{0};
+  std::size_t zeros{0};
+  bool sorted{true};
+
+  double mean() const
+  {
+    const auto count = size - nan;
+    return count == 0 ? std::numeric_limits<double>::quiet_NaN()
+                      : sum / static_cast<double>(count);
+  }
+};
+
+namespace detail::summary {
+
+#if defined(__GNUC__)
+#define JDBG_SIMD_INLINE __attribute__((always_inline)) inline
+#else
+#define JDBG_SIMD_INLINE inline
+#endif
+
+template <typename T>
+struct state {
+  T min{std::numeric_limits<T>::has_infinity
+            ? std::numeric_limits<T>::infinity()
+            : std::numeric_limits<T>::max()};
+  T max{std::numeric_limits<T>::has_infinity
+            ? -std::numeric_limits<T>::infinity()
+            : std::numeric_limits<T>::lowest()};
+  double sum{0};
+  std::size_t nan{0};
+  std::size_t inf{0};
+  std::size_t zeros{0};
+  std::size_t unsorted{0};
+};
+
+// Elements per block whose sum is accumulated in T before adding it to the
+// double total, limiting the rounding error of float sums
+constexpr std::size_t block_elements = 4096;
+
+// dst = mask ? src : dst per lane, spelled with bitwise operations as not
+// every compiler supports ?: on vector types. Vectors are only passed by
+// reference, which keeps their ABI out of the function signature.
+template <typename Vec, typename Mask>
+JDBG_SIMD_INLINE void assign_if(Vec& dst, const Mask& mask, const Vec& src)
+{
+  const auto bits = (__builtin_bit_cast(Mask, src) & mask) |
+                    (__builtin_bit_cast(Mask, dst) & ~mask);
+  dst = __builtin_bit_cast(Vec, bits);
+}
+
+// Vectorised part for floating point types using Bytes wide vectors,
+// returns the index where the caller has to continue with scalar code
+template <typename T, std::size_t Bytes>
+JDBG_SIMD_INLINE std::size_t accumulate_lanes(const T* data, std::size_t size,
+                                              state<T>& st)
+{
+  typedef T vec __attribute__((vector_size(Bytes))); // NOLINT
+  using mask = decltype(vec{} < vec{});
+  constexpr std::size_t lanes = Bytes / sizeof(T);
+  constexpr T inf = std::numeric_limits<T>::infinity();
+
+  vec lo = vec{} + st.min;
+  vec hi = vec{} + st.max;
+
+  // Each step also compares with the element after the lane, so the last
+  // vector must leave one element for the scalar tail
+  std::size_t i = 0;
+  while (i + lanes < size) {
+    const auto block_end = std::min(size - lanes, i + block_elements);
+    vec sum{};
+    mask nans{};
+    mask infs{};
+    mask zeros{};
+    mask unsorted{};
+    for (; i < block_end; i += lanes) {
+      vec x;
+      vec next;
+      std::memcpy(&x, data + i, Bytes);
+      std::memcpy(&next, data + i + 1, Bytes);
+
+      const mask is_nan = x != x;
+      assign_if(lo, x < lo, x);
+      assign_if(hi, x > hi, x);
+      vec summand = x;
+      assign_if(summand, is_nan, vec{});
+      sum += summand;
+      nans -= is_nan;
+      infs -= (x == inf) | (x == -inf);
+      zeros -= x == 0;
+      unsorted -= next < x;
+    }
+
+    T block_sum = 0;
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      block_sum += sum[lane];
+      st.nan += static_cast<std::size_t>(nans[lane]);
+      st.inf += static_cast<std::size_t>(infs[lane]);
+      st.zeros += static_cast<std::size_t>(zeros[lane]);
+      st.unsorted += static_cast<std::size_t>(unsorted[lane]);
+    }
+    st.sum += block_sum;
+  }
+
+  T lo_lanes[lanes];
+  T hi_lanes[lanes];
+  std::memcpy(lo_lanes, &lo, Bytes);
+  std::memcpy(hi_lanes, &hi, Bytes);
+  for (std::size_t lane = 0; lane < lanes; ++lane) {
+    st.min = std::min(st.min, lo_lanes[lane]);
+    st.max = std::max(st.max, hi_lanes[lane]);
+  }
+  return i;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) &&        \
+    !defined(__AVX2__)
+#define JDBG_SUMMARY_AVX2_DISPATCH
+
+// 256-bit lanes for CPUs supporting them, even when the including TU is
+// compiled for baseline x86
+template <typename T>
+__attribute__((target("avx2"))) std::size_t
+accumulate_avx2(const T* data, std::size_t size, state<T>& st)
+{
+  return accumulate_lanes<T, 32>(data, size, st);
+}
+
+inline bool has_avx2()
+{
+  static const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+  return avx2;
+}
+#endif
+
+template <typename T>
+std::size_t accumulate_vectorised(const T* data, std::size_t size, state<T>& st)
+{
+#if defined(JDBG_SUMMARY_AVX2_DISPATCH)
+  if (has_avx2()) {
+    return accumulate_avx2(data, size, st);
+  }
+  return accumulate_lanes<T, 16>(data, size, st);
+#elif defined(__AVX2__)
+  return accumulate_lanes<T, 32>(data, size, st);
+#elif defined(__GNUC__)
+  return accumulate_lanes<T, 16>(data, size, st);
+#else
+  return 0;
+#endif
+}
+
+template <typename T>
+void accumulate_scalar(const T* data, std::size_t begin, std::size_t size,
+                       state<T>& st)
+{
+  for (std::size_t i = begin; i < size; ++i) {
+    const T x = data[i];
+    if (i + 1 < size && data[i + 1] < x) {
+      ++st.unsorted;
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+      if (std::isnan(x)) {
+        ++st.nan;
+        continue;
+      }
+      if (std::isinf(x)) {
+        ++st.inf;
+      }
+    }
+    st.min = std::min(st.min, x);
+    st.max = std::max(st.max, x);
+    st.sum += static_cast<double>(x);
+    if (x == 0) {
+      ++st.zeros;
+    }
+  }
+}
+
+#undef JDBG_SIMD_INLINE
+#undef JDBG_SUMMARY_AVX2_DISPATCH
+
+} // namespace detail::summary
+
+// Vectorised for float and double, integers go through a plain loop the
+// compiler is free to vectorise itself
+template <typename T>
+numeric_summary<T> summarize(const T* data, std::size_t size)
+{
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "summarize() needs a range of numbers");
+
+  detail::summary::state<T> st;
+  std::size_t done = 0;
+  if constexpr (std::is_floating_point_v<T>) {
+    done = detail::summary::accumulate_vectorised(data, size, st);
+  }
+  detail::summary::accumulate_scalar(data, done, size, st);
+
+  numeric_summary<T> res;
+  res.size = size;
+  res.sum = st.sum;
+  res.nan = st.nan;
+  res.inf = st.inf;
+  res.zeros = st.zeros;
+  res.sorted = st.unsorted == 0;
+  if (size > st.nan) {
+    res.min = st.min;
+    res.max = st.max;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    res.min = std::numeric_limits<T>::quiet_NaN();
+    res.max = std::numeric_limits<T>::quiet_NaN();
+  }
+  return res;
+}
+
+// Any contiguous range with std::data(), e.g. std::vector, std::array,
+// std::span and C arrays
+template <typename Range>
+auto summarize(const Range& range)
+    -> numeric_summary<std::remove_cv_t<
+        std::remove_pointer_t<decltype(std::data(range))>>>
+{
+  return summarize(std::data(range),
+                   static_cast<std::size_t>(detail::size(range)));
+}
+
+template <typename T>
+void pretty_print(ostream& os, const numeric_summary<T>& val)
+{
+  os << "{size: " << val.size;
+  if (val.size > 0) {
+    os << ", min: ";
+    pretty_print(os, val.min);
+    os << ", max: ";
+    pretty_print(os, val.max);
+    os << ", mean: ";
+    pretty_print(os, val.mean());
+    os << ", sum: ";
+    pretty_print(os, val.sum);
+    if constexpr (std::is_floating_point_v<T>) {
+      os << ", nan: " << val.nan << ", inf: " << val.inf;
+    }
+    os << ", zeros: " << val.zeros;
+    os << ", sorted: ";
+    pretty_print(os, val.sorted);
+  }
+  os << '}';
+}
+
+template <typename T>
+void json_print(json_writer& json, const numeric_summary<T>& val)
+{
+  json.begin_object();
+  json.key("size");
+  json.number(val.size);
+  if (val.size > 0) {
+    json.key("min");
+    json_print(json, val.min);
+    json.key("max");
+    json_print(json, val.max);
+    json.key("mean");
+    json.number(val.mean());
+    json.key("sum");
+    json.number(val.sum);
+    json.key("nan");
+    json.number(val.nan);
+    json.key("inf");
+    json.number(val.inf);
+    json.key("zeros");
+    json.number(val.zeros);
+    json.key("sorted");
+    json.boolean(val.sorted);
+  }
+  json.end_object();
+}
+
+} // namespace jdbg
@@ -0,0 +1,7 @@
+// Out-of-line definitions of the dbg() formatting core for jdbg::core,
+// which compiles everything with JDBG_COMPILED_CORE defined
+#ifndef JDBG_COMPILED_CORE
+#define JDBG_COMPILED_CORE
+#endif
+
+#include <jdbg/detail/core_impl.hpp>
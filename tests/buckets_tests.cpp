@@ -0,0 +1,142 @@
+#include <jdbg/buckets.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Keeps only the high bits, so runs of keys land in the same bucket
+struct coarse_hash {
+  std::size_t operator()(int key) const
+  {
+    return static_cast<std::size_t>(key) & ~std::size_t{63};
+  }
+};
+
+void check_consistent(const jdbg::bucket_stats& stats)
+{
+  std::size_t buckets = 0;
+  std::size_t elements = 0;
+  for (std::size_t i = 0; i < jdbg::bucket_stats::histogram_size; ++i) {
+    buckets += stats.chains[i];
+    elements += i * stats.chains[i];
+  }
+  CHECK(buckets == stats.bucket_count);
+  if (stats.longest_chain < jdbg::bucket_stats::histogram_size - 1) {
+    CHECK(elements == stats.size);
+  }
+  CHECK(stats.empty_buckets == stats.chains[0]);
+}
+
+} // namespace
+
+TEST_CASE("analyze_buckets")
+{
+  SECTION("empty")
+  {
+    const std::unordered_set<int> s;
+    const auto stats = jdbg::analyze_buckets(s);
+    CHECK(stats.size == 0);
+    CHECK(stats.empty_buckets == stats.bucket_count);
+    CHECK(stats.longest_chain == 0);
+    CHECK(stats.clustering == 0);
+    CHECK_FALSE(stats.is_poor_hash());
+    check_consistent(stats);
+  }
+
+  SECTION("uniform")
+  {
+    std::unordered_map<int, int> m;
+    for (int i = 0; i < 1000; ++i) {
+      m[i * 7919] = i;
+    }
+    const auto stats = jdbg::analyze_buckets(m);
+    CHECK(stats.size == 1000);
+    CHECK(stats.bucket_count == m.bucket_count());
+    CHECK(stats.load_factor == m.load_factor());
+    CHECK(stats.max_load_factor == m.max_load_factor());
+    CHECK(stats.clustering < 1.5);
+    CHECK_FALSE(stats.is_poor_hash());
+    check_consistent(stats);
+  }
+
+  SECTION("poor hash")
+  {
+    std::unordered_set<int, coarse_hash> s;
+    for (int i = 0; i < 1000; ++i) {
+      s.insert(i);
+    }
+    const auto stats = jdbg::analyze_buckets(s);
+    CHECK(stats.longest_chain == 64);
+    CHECK(stats.chains[8] == 1000 / 64 + 1);
+    CHECK(stats.clustering > 10);
+    CHECK(stats.is_poor_hash());
+    check_consistent(stats);
+  }
+
+  SECTION("too small to judge")
+  {
+    std::unordered_set<int, coarse_hash> s{1, 2, 3, 4};
+    const auto stats = jdbg::analyze_buckets(s);
+    CHECK(stats.longest_chain == 4);
+    CHECK_FALSE(stats.is_poor_hash());
+  }
+
+  SECTION("multimap")
+  {
+    std::unordered_multimap<int, int> m;
+    for (int i = 0; i < 5; ++i) {
+      m.emplace(1, i);
+    }
+    const auto stats = jdbg::analyze_buckets(m);
+    CHECK(stats.longest_chain == 5);
+    check_consistent(stats);
+  }
+}
+
+TEST_CASE("bucket_stats printing")
+{
+  jdbg::bucket_stats stats;
+  stats.size = 40;
+  stats.bucket_count = 8;
+  stats.load_factor = 5;
+  stats.max_load_factor = 1;
+  stats.empty_buckets = 6;
+  stats.longest_chain = 30;
+  stats.chains[0] = 6;
+  stats.chains[8] = 2;
+  stats.clustering = 3.5;
+
+  SECTION("pretty_print")
+  {
+    std::ostringstream os;
+    jdbg::pretty_print(os, stats);
+    CHECK_THAT(os.str(),
+               Equals("{size: 40, buckets: 8, load factor: 5, "
+                      "max load factor: 1, empty: 6, longest chain: 30, "
+                      "chains: {0: 6, 8+: 2}, clustering: 3.5, "
+                      "warning: poor hash, elements share buckets far more "
+                      "often than with a uniform hash}"));
+  }
+
+  SECTION("json_print")
+  {
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, stats);
+    CHECK_THAT(buf, Equals(R"({"size":40,"bucket_count":8,"load_factor":5,)"
+                           R"("max_load_factor":1,"empty_buckets":6,)"
+                           R"("longest_chain":30,)"
+                           R"("chains":[6,0,0,0,0,0,0,0,2],)"
+                           R"("clustering":3.5,"poor_hash":true})"));
+  }
+}
@@ -0,0 +1,231 @@
+#include <jdbg/compressed_sink.hpp>
+#include <jdbg/jdbg.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string round_trip(const std::string& data)
+{
+  std::string compressed;
+  jdbg::detail::lz::compress(data.data(), data.size(), compressed);
+  std::string out(data.size(), '\0');
+  if (!jdbg::detail::lz::decompress(compressed.data(), compressed.size(),
+                                    out.data(), out.size())) {
+    return "<malformed>";
+  }
+  return out;
+}
+
+std::string read_file(const std::string& path)
+{
+  std::string content;
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  char buf[4096];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+    content.append(buf, n);
+  }
+  std::fclose(file);
+  return content;
+}
+
+std::string decode(std::string_view data,
+                   jdbg::compressed_file_reader::status& state)
+{
+  jdbg::compressed_file_reader reader{data};
+  std::string out;
+  std::string block;
+  while (reader.next(block)) {
+    out += block;
+  }
+  state = reader.state();
+  return out;
+}
+
+// What the sink has written so far, waiting up to a few seconds for it to
+// become expected
+std::string wait_for(const std::string& path, const std::string& expected)
+{
+  std::string out;
+  for (int i = 0; i < 500; ++i) {
+    const auto file = read_file(path);
+    auto state = jdbg::compressed_file_reader::status::ok;
+    out = decode(file, state);
+    if (out == expected) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  return out;
+}
+
+} // namespace
+
+TEST_CASE("lz block compression")
+{
+  SECTION("edge cases")
+  {
+    CHECK(round_trip("").empty());
+    CHECK(round_trip("a") == "a");
+    CHECK(round_trip("abcd") == "abcd");
+    CHECK(round_trip(std::string(100000, 'x')) == std::string(100000, 'x'));
+  }
+
+  SECTION("repetitive text shrinks")
+  {
+    std::string data;
+    for (int i = 0; data.size() < 60000; ++i) {
+      data += "[main.cpp:42 (main)] v: [" + std::to_string(i) +
+              ", 2, 3] (std::vector<int>)\n";
+    }
+    std::string compressed;
+    jdbg::detail::lz::compress(data.data(), data.size(), compressed);
+
+    CHECK(compressed.size() * 4 < data.size());
+    CHECK(round_trip(data) == data);
+  }
+
+  SECTION("random data")
+  {
+    std::mt19937 gen{42}; // NOLINT
+    std::string data(50000, '\0');
+    for (auto& c : data) {
+      c = static_cast<char>(gen() % 4);
+    }
+    CHECK(round_trip(data) == data);
+  }
+
+  SECTION("malformed input is rejected")
+  {
+    std::string out(16, '\0');
+    const std::string bad{"\x0f\x01", 2};
+    CHECK_FALSE(
+        jdbg::detail::lz::decompress(bad.data(), bad.size(), out.data(), 16));
+  }
+}
+
+TEST_CASE("compressed file sink")
+{
+  char path[] = "/tmp/jdbg-sink-tests-XXXXXX";
+  const int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  std::string expected;
+  {
+    jdbg::compressed_file_sink sink{path, 1024};
+    REQUIRE(sink.is_open());
+    for (int i = 0; i < 500; ++i) {
+      std::string record =
+          "[sink.cpp:1 (f)] i: " + std::to_string(i) + " (int)";
+      sink.write(record);
+      expected += record + '\n';
+    }
+    sink.write(std::string(3000, 'z'));
+    expected += std::string(3000, 'z') + '\n';
+  }
+  const auto file = read_file(path);
+  std::remove(path);
+
+  using status = jdbg::compressed_file_reader::status;
+  auto state = status::ok;
+
+  SECTION("whole file")
+  {
+    CHECK(file.size() < expected.size());
+    CHECK(decode(file, state) == expected);
+    CHECK(state == status::end);
+  }
+
+  SECTION("truncated tail")
+  {
+    const auto truncated = std::string_view{file}.substr(0, file.size() - 5);
+    const auto out = decode(truncated, state);
+    CHECK(state == status::truncated);
+    CHECK(!out.empty());
+    CHECK(expected.compare(0, out.size(), out) == 0);
+  }
+
+  SECTION("corrupt block")
+  {
+    auto corrupt = file;
+    corrupt[corrupt.size() / 2] ^= 0x55;
+    const auto out = decode(corrupt, state);
+    CHECK(state == status::corrupt);
+    CHECK(expected.compare(0, out.size(), out) == 0);
+  }
+}
+
+TEST_CASE("compressed file sink flushing")
+{
+  char path[] = "/tmp/jdbg-sink-tests-XXXXXX";
+  const int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  constexpr std::chrono::hours never{1};
+
+  SECTION("record limit")
+  {
+    jdbg::compressed_file_sink sink{path, 64 * 1024, 3, never};
+    sink.write("a");
+    sink.write("b");
+    sink.write("c");
+    sink.write("d");
+    CHECK(wait_for(path, "a\nb\nc\n") == "a\nb\nc\n");
+  }
+
+  SECTION("time limit")
+  {
+    jdbg::compressed_file_sink sink{path, 64 * 1024, 1000,
+                                    std::chrono::milliseconds{20}};
+    sink.write("a");
+    CHECK(wait_for(path, "a\n") == "a\n");
+    sink.write("b");
+    CHECK(wait_for(path, "a\nb\n") == "a\nb\n");
+  }
+
+  SECTION("jdbg::flush()")
+  {
+    jdbg::compressed_file_sink sink{path, 64 * 1024, 1000, never};
+    sink.write("a");
+    jdbg::flush();
+    auto state = jdbg::compressed_file_reader::status::ok;
+    CHECK(decode(read_file(path), state) == "a\n");
+  }
+
+  SECTION("crash")
+  {
+    const auto pid = fork();
+    if (pid == 0) {
+      jdbg::compressed_file_sink sink{path, 64 * 1024, 1000,
+                                      std::chrono::milliseconds{20}};
+      sink.write("before");
+      std::this_thread::sleep_for(std::chrono::milliseconds{500});
+      // Dies with this record younger than the time limit
+      sink.write("lost");
+      raise(SIGKILL);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFSIGNALED(status));
+    auto state = jdbg::compressed_file_reader::status::ok;
+    CHECK(decode(read_file(path), state) == "before\n");
+  }
+
+  std::remove(path);
+}
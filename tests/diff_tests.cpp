@@ -0,0 +1,193 @@
+#include <jdbg/diff.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template <typename T>
+std::string pretty_print_diff(const T& prev, const T& cur)
+{
+  std::stringstream ss;
+  jdbg::pretty_print_diff(ss, prev, cur);
+  return ss.str();
+}
+
+struct my_struct {
+  int x;
+};
+
+std::ostream& operator<<(std::ostream& os, const my_struct& ms)
+{
+  os << "my_struct{" << ms.x << "}";
+  return os;
+}
+
+} // namespace
+
+TEST_CASE("pretty print diff")
+{
+  SECTION("primitives")
+  {
+    CHECK_THAT(pretty_print_diff(1, 1), Equals(""));
+    CHECK_THAT(pretty_print_diff(1, 2), Equals("1 -> 2"));
+    CHECK_THAT(pretty_print_diff(std::string{"a"}, std::string{"b"}),
+               Equals("\"a\" -> \"b\""));
+  }
+
+  SECTION("std::vector")
+  {
+    CHECK_THAT(
+        pretty_print_diff(std::vector<int>{1, 2}, std::vector<int>{1, 2}),
+        Equals(""));
+    CHECK_THAT(
+        pretty_print_diff(std::vector<int>{1, 2, 3}, std::vector<int>{1, 5}),
+        Equals("{~[1]: 2 -> 5, -[2]: 3}"));
+    CHECK_THAT(pretty_print_diff(std::vector<int>{}, std::vector<int>{7}),
+               Equals("{+[0]: 7}"));
+    CHECK_THAT(
+        pretty_print_diff(std::vector<int>(12, 0), std::vector<int>(12, 1)),
+        EndsWith("~[9]: 0 -> 1, ... changes: 12}"));
+  }
+
+  SECTION("std::map")
+  {
+    const std::map<std::string, int> prev{{"a", 1}, {"b", 2}, {"c", 3}};
+    const std::map<std::string, int> cur{{"a", 1}, {"b", 4}, {"d", 5}};
+    CHECK_THAT(pretty_print_diff(prev, cur),
+               Equals("{~\"b\": 2 -> 4, +\"d\": 5, -\"c\": 3}"));
+  }
+
+  SECTION("std::unordered_map")
+  {
+    std::unordered_map<int, int> prev;
+    for (int i = 0; i < 1000; ++i) {
+      prev.emplace(i, i);
+    }
+    auto cur = prev;
+    cur[500] = -1;
+    CHECK_THAT(pretty_print_diff(prev, cur), Equals("{~500: 500 -> -1}"));
+  }
+
+  SECTION("std::set")
+  {
+    CHECK_THAT(pretty_print_diff(std::set<int>{1, 2}, std::set<int>{2, 3}),
+               Equals("{+3, -1}"));
+  }
+
+  SECTION("std::multimap")
+  {
+    const std::multimap<int, int> prev{{1, 10}, {1, 11}, {2, 20}};
+    const std::multimap<int, int> cur{{1, 10}, {1, 12}, {1, 13}};
+    CHECK_THAT(pretty_print_diff(prev, cur),
+               Equals("{~1: 11 -> 12, +1: 13, -2: 20}"));
+    CHECK_THAT(pretty_print_diff(prev, prev), Equals(""));
+  }
+
+  SECTION("std::multiset")
+  {
+    CHECK_THAT(pretty_print_diff(std::multiset<int>{1, 1, 2},
+                                 std::multiset<int>{1, 2, 2}),
+               Equals("{-1, +2}"));
+  }
+
+  SECTION("std::pair and std::tuple")
+  {
+    CHECK_THAT(pretty_print_diff(std::pair{1, 2.5}, std::pair{1, 3.5}),
+               Equals("{~second: 2.5 -> 3.5}"));
+    CHECK_THAT(pretty_print_diff(std::tuple{1, 'a', 2}, std::tuple{0, 'a', 3}),
+               Equals("{~get<0>: 1 -> 0, ~get<2>: 2 -> 3}"));
+  }
+
+  SECTION("C arrays")
+  {
+    const int prev[3] = {1, 2, 3};
+    const int cur[3] = {1, 5, 3};
+    CHECK_THAT(pretty_print_diff(prev, cur), Equals("{~[1]: 2 -> 5}"));
+  }
+
+  SECTION("NaN")
+  {
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    CHECK_THAT(pretty_print_diff(nan, nan), Equals(""));
+    CHECK_THAT(pretty_print_diff(std::vector<double>{1, nan},
+                                 std::vector<double>{1, nan}),
+               Equals(""));
+    CHECK_THAT(pretty_print_diff(std::map<int, float>{{1, std::nanf("")}},
+                                 std::map<int, float>{{1, std::nanf("")}}),
+               Equals(""));
+    CHECK_THAT(pretty_print_diff(std::pair{1, nan}, std::pair{1, nan}),
+               Equals(""));
+    CHECK_THAT(pretty_print_diff(std::vector<double>{nan, 2},
+                                 std::vector<double>{1, 2}),
+               Equals("{~[0]: nan -> 1}"));
+    CHECK_THAT(pretty_print_diff(std::vector<double>{0.5},
+                                 std::vector<double>{nan}),
+               Equals("{~[0]: 0.5 -> nan}"));
+  }
+
+  SECTION("elements without operator==")
+  {
+    const std::vector<my_struct> prev{{1}, {2}};
+    const std::vector<my_struct> cur{{1}, {3}};
+    CHECK_THAT(pretty_print_diff(prev, cur),
+               Equals("{~[1]: my_struct{2} -> my_struct{3}}"));
+  }
+}
+
+TEST_CASE("diff_state")
+{
+  SECTION("C array")
+  {
+    using state_type = jdbg::detail::diff_state<int[3]>;
+    state_type state;
+    int a[3] = {1, 2, 3};
+    std::stringstream ss;
+    CHECK(state.update(ss, a) == state_type::result::initial);
+    CHECK(state.update(ss, a) == state_type::result::unchanged);
+    a[1] = 20;
+    CHECK(state.update(ss, a) == state_type::result::changed);
+    CHECK_THAT(ss.str(), Equals("{~[1]: 2 -> 20}"));
+    CHECK(state.update(ss, a) == state_type::result::unchanged);
+  }
+
+  SECTION("NaN")
+  {
+    using state_type = jdbg::detail::diff_state<std::vector<double>>;
+    state_type state;
+    const std::vector<double> v{1, std::numeric_limits<double>::quiet_NaN()};
+    std::stringstream ss;
+    CHECK(state.update(ss, v) == state_type::result::initial);
+    CHECK(state.update(ss, v) == state_type::result::unchanged);
+    CHECK(state.update(ss, v) == state_type::result::unchanged);
+    CHECK(ss.str().empty());
+  }
+
+  SECTION("nested C array")
+  {
+    using state_type = jdbg::detail::diff_state<int[2][2]>;
+    state_type state;
+    int a[2][2] = {{1, 2}, {3, 4}};
+    std::stringstream ss;
+    state.update(ss, a);
+    a[1][0] = 30;
+    CHECK(state.update(ss, a) == state_type::result::changed);
+    CHECK_THAT(ss.str(), Equals("{~[1]: [3, 4] -> [30, 4]}"));
+  }
+}
@@ -0,0 +1,200 @@
+#include <jdbg/dump.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+class temp_file {
+public:
+  temp_file()
+  {
+    const int fd = mkstemp(path_);
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  ~temp_file() { unlink(path_); }
+
+  temp_file(const temp_file&) = delete;
+  temp_file& operator=(const temp_file&) = delete;
+
+  const char* path() const { return path_; }
+
+  std::string read() const
+  {
+    std::string content;
+    std::FILE* file = std::fopen(path_, "rb");
+    char buf[4096];
+    std::size_t n = 0;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+      content.append(buf, n);
+    }
+    std::fclose(file);
+    return content;
+  }
+
+private:
+  char path_[32] = "/tmp/jdbg-dump-tests-XXXXXX";
+};
+
+// Prints like a number, except for the one value that fails to format
+struct fragile {
+  std::size_t value;
+  std::size_t failing;
+};
+
+std::ostream& operator<<(std::ostream& os, const fragile& val)
+{
+  if (val.value == val.failing) {
+    throw std::runtime_error{"cannot format " + std::to_string(val.value)};
+  }
+  return os << val.value;
+}
+
+std::vector<fragile> fragile_values(std::size_t count, std::size_t failing)
+{
+  std::vector<fragile> v(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    v[i] = {i, failing};
+  }
+  return v;
+}
+
+std::string expected_lines(std::size_t count)
+{
+  std::string expected;
+  for (std::size_t i = 0; i < count; ++i) {
+    expected += std::to_string(i);
+    expected += '\n';
+  }
+  return expected;
+}
+
+} // namespace
+
+TEST_CASE("dump")
+{
+  const temp_file file;
+
+  SECTION("small container")
+  {
+    const std::map<std::string, int> m{{"one", 1}, {"two", 2}};
+    const auto result = jdbg::dump(file.path(), m);
+
+    CHECK(result.error == 0);
+    CHECK(result.elements == 2);
+    CHECK(file.read() == "(\"one\", 1)\n(\"two\", 2)\n");
+    CHECK(result.bytes == file.read().size());
+  }
+
+  SECTION("empty container")
+  {
+    const auto result = jdbg::dump(file.path(), std::vector<int>{});
+
+    CHECK(result.error == 0);
+    CHECK(result.elements == 0);
+    CHECK(file.read().empty());
+  }
+
+  SECTION("random access container in parallel chunks")
+  {
+    // Not a multiple of the chunk size, so the last chunk is a partial one
+    constexpr std::size_t count = 20 * jdbg::detail::dump::chunk_elements + 7;
+    std::vector<std::size_t> v(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      v[i] = i;
+    }
+    const auto result = jdbg::dump(file.path(), v);
+
+    CHECK(result.error == 0);
+    CHECK(result.elements == count);
+    CHECK(result.bytes == expected_lines(count).size());
+    CHECK(file.read() == expected_lines(count));
+  }
+
+  SECTION("forward iterator container")
+  {
+    constexpr std::size_t count = 3 * jdbg::detail::dump::chunk_elements + 1;
+    std::list<std::size_t> l;
+    for (std::size_t i = 0; i < count; ++i) {
+      l.push_back(i);
+    }
+    const auto result = jdbg::dump(file.path(), l);
+
+    CHECK(result.error == 0);
+    CHECK(file.read() == expected_lines(count));
+  }
+
+  SECTION("unordered container in iteration order")
+  {
+    std::unordered_map<int, int> m;
+    for (int i = 0; i < 50000; ++i) {
+      m[i] = -i;
+    }
+    std::string expected;
+    for (const auto& [key, val] : m) {
+      expected +=
+          "(" + std::to_string(key) + ", " + std::to_string(val) + ")\n";
+    }
+    jdbg::dump(file.path(), m);
+
+    CHECK(file.read() == expected);
+  }
+
+  SECTION("json lines")
+  {
+    const std::vector<std::vector<int>> v{{1, 2}, {}, {3}};
+    jdbg::dump(file.path(), v, true);
+
+    CHECK(file.read() == "[1,2]\n[]\n[3]\n");
+  }
+
+  SECTION("exception while formatting")
+  {
+    const auto v = fragile_values(10, 4);
+    CHECK_THROWS_WITH(jdbg::dump(file.path(), v), "cannot format 4");
+  }
+
+  SECTION("exception while formatting in parallel chunks")
+  {
+    constexpr auto chunk = jdbg::detail::dump::chunk_elements;
+    const auto v = fragile_values(40 * chunk, 25 * chunk + 3);
+    CHECK_THROWS_WITH(jdbg::dump(file.path(), v),
+                      "cannot format " + std::to_string(25 * chunk + 3));
+    // The chunks before the failing one were written, nothing after it
+    CHECK(file.read() == expected_lines(25 * chunk));
+
+    // The thread pool is still usable
+    const auto other = fragile_values(3 * chunk, 3 * chunk);
+    CHECK(jdbg::dump(file.path(), other).error == 0);
+    CHECK(file.read() == expected_lines(3 * chunk));
+  }
+
+  SECTION("unwritable path")
+  {
+    const std::vector<int> v{1, 2, 3};
+    const auto result = jdbg::dump("/nonexistent/dir/dump.txt", v);
+
+    CHECK(result.error == ENOENT);
+    CHECK_THAT(jdbg::detail::dump::describe(result, "/nonexistent"),
+               StartsWith("cannot dump to /nonexistent: "));
+  }
+}
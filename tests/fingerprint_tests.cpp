@@ -0,0 +1,238 @@
+#include <jdbg/fingerprint.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template <typename T>
+std::uint64_t hash_of(const T& val)
+{
+  return jdbg::fingerprint_of(val).hash;
+}
+
+struct point {
+  int x;
+  int y;
+};
+
+std::ostream& operator<<(std::ostream& os, const point& p)
+{
+  return os << p.x << ',' << p.y;
+}
+
+} // namespace
+
+TEST_CASE("hash_bulk")
+{
+  SECTION("stable")
+  {
+    // Fingerprints are compared between runs and builds, so the hash of a
+    // given input must never change
+    const std::string text = "The quick brown fox jumps over the lazy dog";
+    CHECK(jdbg::detail::hash_bulk(text.data(), text.size()) ==
+          0x0cedfd870dfaae2bULL);
+  }
+
+  SECTION("length")
+  {
+    const std::vector<unsigned char> zeros(300, 0);
+    std::set<std::uint64_t> hashes;
+    for (std::size_t size = 0; size <= zeros.size(); ++size) {
+      hashes.insert(jdbg::detail::hash_bulk(zeros.data(), size));
+    }
+    CHECK(hashes.size() == zeros.size() + 1);
+  }
+
+  SECTION("every bit")
+  {
+    std::vector<unsigned char> data(3000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<unsigned char>(i * 7);
+    }
+    std::set<std::uint64_t> hashes{
+        jdbg::detail::hash_bulk(data.data(), data.size())};
+    for (std::size_t i = 0; i < data.size(); i += 13) {
+      data[i] ^= 1U << (i % 8);
+      hashes.insert(jdbg::detail::hash_bulk(data.data(), data.size()));
+      data[i] ^= 1U << (i % 8);
+    }
+    CHECK(hashes.size() == 1 + (data.size() + 12) / 13);
+  }
+
+  SECTION("stripe order")
+  {
+    std::vector<std::uint64_t> a(64);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      a[i] = i;
+    }
+    auto b = a;
+    // Swaps two stripes of 8 words within the first block
+    std::swap_ranges(b.begin(), b.begin() + 8, b.begin() + 8);
+    CHECK(jdbg::detail::hash_bulk(a.data(), a.size() * 8) !=
+          jdbg::detail::hash_bulk(b.data(), b.size() * 8));
+  }
+}
+
+TEST_CASE("fingerprint_of")
+{
+  SECTION("equal values")
+  {
+    const std::map<std::string, std::vector<double>> a{{"a", {1, 2}},
+                                                       {"b", {}}};
+    auto b = a;
+    CHECK(hash_of(a) == hash_of(b));
+    b["b"].push_back(0);
+    CHECK(hash_of(a) != hash_of(b));
+  }
+
+  SECTION("order")
+  {
+    CHECK(hash_of(std::vector<int>{1, 2}) != hash_of(std::vector<int>{2, 1}));
+    CHECK(hash_of(std::list<int>{1, 2}) != hash_of(std::list<int>{2, 1}));
+    CHECK(hash_of(std::make_pair(1, 2)) != hash_of(std::make_pair(2, 1)));
+  }
+
+  SECTION("unordered")
+  {
+    std::unordered_set<std::string> a{"x", "y", "z"};
+    std::unordered_set<std::string> b(1000);
+    b.insert({"z", "y", "x"});
+    CHECK(hash_of(a) == hash_of(b));
+
+    const std::unordered_multiset<int> twice{1, 1};
+    const std::unordered_multiset<int> none{};
+    const std::unordered_multiset<int> other{2, 2};
+    CHECK(hash_of(twice) != hash_of(none));
+    CHECK(hash_of(twice) != hash_of(other));
+
+    const std::unordered_map<int, std::string> m1{{1, "a"}, {2, "b"}};
+    const std::unordered_map<int, std::string> m2{{2, "b"}, {1, "a"}};
+    const std::unordered_map<int, std::string> m3{{1, "b"}, {2, "a"}};
+    CHECK(hash_of(m1) == hash_of(m2));
+    CHECK(hash_of(m1) != hash_of(m3));
+  }
+
+  SECTION("nesting")
+  {
+    using nested = std::vector<std::vector<int>>;
+    CHECK(hash_of(nested{{1, 2}, {3}}) != hash_of(nested{{1}, {2, 3}}));
+    CHECK(hash_of(nested{{}, {}}) != hash_of(nested{{}}));
+  }
+
+  SECTION("strings")
+  {
+    const char array[8] = "abc";
+    const char* ptr = "abc";
+    CHECK(hash_of(array) == hash_of(std::string{"abc"}));
+    CHECK(hash_of(ptr) == hash_of(std::string_view{"abc"}));
+    CHECK(hash_of(std::string{"ab"}) != hash_of(std::string{"abc"}));
+    CHECK(hash_of(static_cast<const char*>(nullptr)) !=
+          hash_of(std::string{}));
+  }
+
+  SECTION("pointers")
+  {
+    const auto a = std::make_unique<int>(42);
+    const auto b = std::make_unique<int>(42);
+    const auto c = std::make_shared<int>(43);
+    CHECK(hash_of(a) == hash_of(b));
+    CHECK(hash_of(a.get()) == hash_of(b.get()));
+    CHECK(hash_of(a) != hash_of(c));
+    CHECK(hash_of(std::unique_ptr<int>{}) != hash_of(a));
+  }
+
+  SECTION("optional and variant")
+  {
+    CHECK(hash_of(std::optional<int>{}) != hash_of(std::optional<int>{0}));
+    CHECK(hash_of(std::optional<int>{1}) != hash_of(std::optional<int>{2}));
+
+    using var = std::variant<int, unsigned>;
+    CHECK(hash_of(var{1}) != hash_of(var{1U}));
+    CHECK(hash_of(var{1}) == hash_of(var{1}));
+  }
+
+  SECTION("numbers")
+  {
+    CHECK(hash_of(1) != hash_of(2));
+    CHECK(hash_of(1) != hash_of(1L));
+    CHECK(hash_of(0.0) != hash_of(-0.0));
+    CHECK(hash_of(1.0F) != hash_of(1.0));
+    CHECK(hash_of(1.5L) == hash_of(1.5L));
+  }
+
+  SECTION("bulk")
+  {
+    std::vector<std::array<float, 3>> a(1000);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      a[i] = {static_cast<float>(i), 0, 1};
+    }
+    const auto b = a;
+    CHECK(hash_of(a) == hash_of(b));
+    a.back()[2] = 2;
+    CHECK(hash_of(a) != hash_of(b));
+
+    const int carray[3] = {1, 2, 3};
+    CHECK(hash_of(carray) == hash_of(std::array<int, 3>{1, 2, 3}));
+  }
+
+  SECTION("ostream operator")
+  {
+    CHECK(hash_of(point{1, 2}) == hash_of(point{1, 2}));
+    CHECK(hash_of(point{1, 2}) != hash_of(point{2, 1}));
+  }
+
+  SECTION("elements")
+  {
+    using nested = std::vector<std::vector<int>>;
+    CHECK(jdbg::fingerprint_of(42).elements == 1);
+    CHECK(jdbg::fingerprint_of(nested{{1, 2}, {3}}).elements == 3);
+    CHECK(jdbg::fingerprint_of(std::map<std::string, int>{{"a", 1}, {"b", 2}})
+              .elements == 4);
+    CHECK(jdbg::fingerprint_of(std::vector<std::array<float, 3>>(2))
+              .elements == 6);
+    CHECK(jdbg::fingerprint_of(std::make_tuple(std::optional<int>{}, "x",
+                                               std::list<point>(2)))
+              .elements == 4);
+  }
+}
+
+TEST_CASE("fingerprint printing")
+{
+  const jdbg::fingerprint val{0x1234abcdULL, 3};
+
+  SECTION("pretty_print")
+  {
+    std::ostringstream os;
+    jdbg::pretty_print(os, val);
+    CHECK_THAT(os.str(), Equals("{hash: 000000001234abcd, elements: 3}"));
+  }
+
+  SECTION("json_print")
+  {
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, val);
+    CHECK_THAT(buf, Equals(R"({"hash":"000000001234abcd","elements":3})"));
+  }
+}
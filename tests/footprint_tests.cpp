@@ -0,0 +1,190 @@
+#include <jdbg/footprint.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Long enough to never fit a short string buffer
+const std::string long_text(100, 'x');
+
+void check_consistent(const jdbg::footprint& val)
+{
+  std::size_t used = 0;
+  std::size_t reserved = 0;
+  for (const auto& level : val.levels) {
+    CHECK(level.used <= level.reserved);
+    used += level.used;
+    reserved += level.reserved;
+  }
+  CHECK(used == val.used);
+  CHECK(reserved == val.reserved);
+}
+
+} // namespace
+
+TEST_CASE("footprint_of")
+{
+  SECTION("no heap")
+  {
+    const auto res = jdbg::footprint_of(42);
+    CHECK(res.inline_size == sizeof(int));
+    CHECK(res.reserved == 0);
+    CHECK(res.levels.empty());
+
+    const std::pair<int, std::array<double, 4>> pair{};
+    CHECK(jdbg::footprint_of(pair).levels.empty());
+    CHECK(jdbg::footprint_of(std::string_view{long_text}).levels.empty());
+    CHECK(jdbg::footprint_of(&long_text).levels.empty());
+  }
+
+  SECTION("vector capacity")
+  {
+    std::vector<int> v;
+    v.reserve(100);
+    v.assign(10, 1);
+    const auto res = jdbg::footprint_of(v);
+    CHECK(res.inline_size == sizeof(v));
+    REQUIRE(res.levels.size() == 1);
+    CHECK(res.used == 10 * sizeof(int));
+    CHECK(res.reserved == 100 * sizeof(int));
+    CHECK(res.slack() == 90 * sizeof(int));
+    check_consistent(res);
+  }
+
+  SECTION("strings")
+  {
+    const std::string small = "ab";
+    CHECK(jdbg::footprint_of(small).levels.empty());
+
+    const auto res = jdbg::footprint_of(long_text);
+    CHECK(res.used == long_text.size());
+    CHECK(res.reserved == long_text.capacity() + 1);
+  }
+
+  SECTION("nested")
+  {
+    std::map<std::string, std::vector<std::string>> m;
+    auto& values = m[long_text];
+    values.reserve(20);
+    values.push_back(long_text);
+    values.push_back("short");
+    const auto res = jdbg::footprint_of(m);
+
+    REQUIRE(res.levels.size() == 3);
+    using node_type = std::pair<const std::string, std::vector<std::string>>;
+    CHECK(res.levels[0].used == sizeof(node_type));
+    CHECK(res.levels[0].reserved ==
+          jdbg::detail::heap::node_size<node_type>(4));
+    // The key and the vector of the node
+    CHECK(res.levels[1].used ==
+          long_text.size() + 2 * sizeof(std::string));
+    CHECK(res.levels[1].slack() ==
+          long_text.capacity() + 1 - long_text.size() +
+              18 * sizeof(std::string));
+    CHECK(res.levels[2].used == long_text.size());
+    check_consistent(res);
+  }
+
+  SECTION("nodes")
+  {
+    const std::list<int> l{1, 2, 3};
+    const auto list_res = jdbg::footprint_of(l);
+    CHECK(list_res.used == 3 * sizeof(int));
+    CHECK(list_res.reserved == 3 * jdbg::detail::heap::node_size<int>(2));
+
+    std::unordered_map<int, int> u{{1, 2}, {3, 4}};
+    const auto res = jdbg::footprint_of(u);
+    REQUIRE(res.levels.size() == 1);
+    CHECK(res.used == 2 * sizeof(std::pair<const int, int>));
+    CHECK(res.reserved ==
+          2 * jdbg::detail::heap::node_size<std::pair<const int, int>>(1) +
+              u.bucket_count() * sizeof(void*));
+  }
+
+  SECTION("smart pointers")
+  {
+    auto ptr = std::make_unique<std::vector<int>>(8);
+    const auto res = jdbg::footprint_of(ptr);
+    REQUIRE(res.levels.size() == 2);
+    CHECK(res.levels[0].used == sizeof(std::vector<int>));
+    CHECK(res.levels[1].used == 8 * sizeof(int));
+    CHECK(jdbg::footprint_of(std::unique_ptr<int>{}).levels.empty());
+
+    // Shared values are counted once
+    const auto shared = std::make_shared<std::string>(long_text);
+    const std::vector<std::shared_ptr<std::string>> v{shared, shared};
+    const auto shared_res = jdbg::footprint_of(v);
+    REQUIRE(shared_res.levels.size() == 3);
+    CHECK(shared_res.levels[1].used == sizeof(std::string));
+    CHECK(shared_res.levels[2].used == long_text.size());
+    check_consistent(shared_res);
+  }
+
+  SECTION("optional and variant")
+  {
+    const std::optional<std::string> opt{long_text};
+    CHECK(jdbg::footprint_of(opt).used == long_text.size());
+    const std::variant<int, std::string> var{long_text};
+    CHECK(jdbg::footprint_of(var).used == long_text.size());
+  }
+}
+
+TEST_CASE("footprint printing")
+{
+  jdbg::footprint res;
+  res.inline_size = 48;
+  res.used = 300;
+  res.reserved = 1000;
+  res.levels.push_back({100, 200});
+  res.levels.push_back({200, 800});
+
+  SECTION("pretty_print")
+  {
+    std::ostringstream os;
+    jdbg::pretty_print(os, res);
+    CHECK_THAT(os.str(),
+               Equals("{inline: 48, used: 300, reserved: 1000, slack: 700, "
+                      "levels: [{used: 100, reserved: 200, slack: 100}, "
+                      "{used: 200, reserved: 800, slack: 600}]}"));
+  }
+
+  SECTION("pretty_print partial")
+  {
+    res.is_partial = true;
+    std::ostringstream os;
+    jdbg::pretty_print(os, res);
+    CHECK_THAT(os.str(),
+               EndsWith("], warning: pointers nested too deep were not "
+                        "followed}"));
+  }
+
+  SECTION("json_print")
+  {
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, res);
+    CHECK_THAT(buf, Equals(R"({"inline_size":48,"used":300,)"
+                           R"("reserved":1000,"slack":700,"levels":[)"
+                           R"({"used":100,"reserved":200,"slack":100},)"
+                           R"({"used":200,"reserved":800,"slack":600}],)"
+                           R"("partial":false})"));
+  }
+}
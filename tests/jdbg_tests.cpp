@@ -1,5 +1,9 @@
 #define JDBG_LOG_FUNCTION(str) std::cerr << (str)
 #define JDBG_IS_OUTPUT_COLOURED (false)
+#define JDBG_IS_OUTPUT_JSON (is_output_json)
+namespace {
+bool is_output_json = false; // NOLINT
+} // namespace
 #include <jdbg/jdbg.hpp>
 #include <jdbg/type_name.hpp>
 
@@ -7,14 +11,23 @@
 #include <catch2/matchers/catch_matchers.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
+#include <array>
+#include <cstddef>
+#include <cstdio>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <streambuf>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 using namespace Catch::Matchers;
 
 namespace {
@@ -52,7 +65,7 @@ private:
 
 class jdbg_tests {
 public:
-  jdbg_tests() : redirecter_{output} {}
+  jdbg_tests() : redirecter_{output} { is_output_json = false; }
 
 protected:
   std::ostringstream output;
@@ -91,3 +104,342 @@ TEST_CASE_METHOD(jdbg_tests, "dbg macro")
     CHECK_THAT(output.str(), ContainsSubstring("\"two\""));
   }
 }
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_diff macro")
+{
+  std::map<int, int> m{{1, 1}, {2, 2}};
+  std::vector<std::string> lines;
+  for (int i = 0; i < 4; ++i) {
+    if (i == 2) {
+      m[2] = 20;
+      m.erase(1);
+    }
+    auto& ref = dbg_diff(m);
+    CHECK(&ref == &m);
+    lines.push_back(std::exchange(output, std::ostringstream{}).str());
+  }
+
+  CHECK_THAT(lines[0], ContainsSubstring("m: [(1, 1), (2, 2)]"));
+  CHECK_THAT(lines[1], Equals(""));
+  CHECK_THAT(lines[2], ContainsSubstring("m: {~2: 2 -> 20, -1: 1}"));
+  CHECK_THAT(lines[3], Equals(""));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_diff macro with a C array")
+{
+  int a[3] = {1, 2, 3};
+  std::vector<std::string> lines;
+  for (int i = 0; i < 3; ++i) {
+    if (i == 2) {
+      a[1] = 20;
+    }
+    dbg_diff(a);
+    lines.push_back(std::exchange(output, std::ostringstream{}).str());
+  }
+
+  CHECK_THAT(lines[0], ContainsSubstring("a: [1, 2, 3]"));
+  CHECK_THAT(lines[1], Equals(""));
+  CHECK_THAT(lines[2], ContainsSubstring("a: {~[1]: 2 -> 20}"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_dedup macro")
+{
+  SECTION("raw values")
+  {
+    for (int i = 0; i < 6; ++i) {
+      const int val = i < 4 ? 7 : 8;
+      CHECK(dbg_dedup(val) == val);
+    }
+    jdbg::flush();
+
+    const auto out = output.str();
+    CHECK_THAT(out, ContainsSubstring("val: 7 (const int)[jdbg_tests.cpp"));
+    CHECK_THAT(out,
+               ContainsSubstring("val: (repeated 3 times)[jdbg_tests.cpp"));
+    CHECK_THAT(out, ContainsSubstring("val: 8 (const int)[jdbg_tests.cpp"));
+    CHECK_THAT(out, EndsWith("val: (repeated 1 time)"));
+  }
+
+  SECTION("equal hashes")
+  {
+    std::vector<std::string> printed;
+    {
+      jdbg::detail::dedup_state state{
+          jdbg::detail::output{"jdbg_tests.cpp", 1, "test", "val"}};
+      for (const std::string_view text : {"a", "b", "b", "bb"}) {
+        state.update(0, text, [&] { printed.emplace_back(text); });
+      }
+    }
+
+    CHECK(printed == std::vector<std::string>{"a", "b", "bb"});
+    CHECK_THAT(output.str(), EndsWith("val: (repeated 1 time)"));
+  }
+
+  SECTION("formatted values")
+  {
+    const std::vector<std::string> v{"a", "b"};
+    for (int i = 0; i < 3; ++i) {
+      dbg_dedup(v);
+      dbg_dedup("polling");
+    }
+    jdbg::flush();
+    jdbg::flush();
+
+    const auto out = output.str();
+    CHECK_THAT(out, ContainsSubstring("v: [\"a\", \"b\"]"));
+    CHECK_THAT(out, ContainsSubstring("v: (repeated 2 times)"));
+    CHECK_THAT(out, ContainsSubstring("\"polling\": (repeated 2 times)"));
+    std::size_t records = 0;
+    for (auto pos = out.find("[jdbg_tests.cpp:"); pos != std::string::npos;
+         pos = out.find("[jdbg_tests.cpp:", pos + 1)) {
+      ++records;
+    }
+    CHECK(records == 4);
+  }
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg macro json output")
+{
+  is_output_json = true;
+
+  SECTION("expression record")
+  {
+    const std::vector<int> v{1, 2, 3};
+    const auto& ref = dbg(v);
+
+    CHECK(&ref == &v);
+    CHECK_THAT(output.str(), StartsWith("{\"file\":\"jdbg_tests.cpp\","));
+    CHECK_THAT(output.str(), ContainsSubstring("\"func\":\""));
+    CHECK_THAT(output.str(), ContainsSubstring("\"thread\":"));
+    CHECK_THAT(output.str(), ContainsSubstring("\"timestamp\":"));
+    CHECK_THAT(output.str(),
+               EndsWith("\"expr\":\"v\",\"type\":\"const "
+                        "std::vector<int>\",\"value\":[1,2,3]}"));
+  }
+
+  SECTION("message record")
+  {
+    dbg("hello \"world\"");
+
+    CHECK_THAT(output.str(),
+               EndsWith("\"value\":\"hello \\\"world\\\"\"}"));
+    CHECK_THAT(output.str(), !ContainsSubstring("\"expr\""));
+  }
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_dump macro")
+{
+  char path[] = "/tmp/jdbg-dump-macro-XXXXXX";
+  close(mkstemp(path));
+
+  const std::vector<int> v{1, 2, 3};
+  const auto& ref = dbg_dump(v, path);
+  unlink(path);
+
+  CHECK(&ref == &v);
+  CHECK_THAT(output.str(),
+             EndsWith(std::string{"v: dumped 3 elements (6 bytes) to "} +
+                      path + " (const std::vector<int>)"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_summary macro")
+{
+  const std::vector<double> v{1.5, 0, 3};
+  const auto& ref = dbg_summary(v);
+
+  CHECK(&ref == &v);
+  CHECK_THAT(output.str(),
+             EndsWith("v: {size: 3, min: 0, max: 3, mean: 1.5, sum: 4.5, "
+                      "nan: 0, inf: 0, zeros: 1, sorted: false} "
+                      "(const std::vector<double>)"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_buckets macro")
+{
+  const std::unordered_set<int> s{1, 2, 3};
+  const auto& ref = dbg_buckets(s);
+
+  CHECK(&ref == &s);
+  CHECK_THAT(output.str(), ContainsSubstring("s: {size: 3, buckets: " +
+                                             std::to_string(s.bucket_count())));
+  CHECK_THAT(output.str(), ContainsSubstring("longest chain: 1, chains: {0: "));
+  CHECK_THAT(output.str(), EndsWith("} (const std::unordered_set<int>)"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_hash macro")
+{
+  const std::vector<std::string> v{"a", "b", "c"};
+  const auto& ref = dbg_hash(v);
+  const auto hash = jdbg::fingerprint_of(v).hash;
+  std::string hex;
+  jdbg::detail::writer{hex}.write_hex(hash, 16);
+
+  CHECK(&ref == &v);
+  CHECK_THAT(output.str(),
+             EndsWith("v: {hash: " + hex +
+                      ", elements: 3} (const std::vector<std::string>)"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_footprint macro")
+{
+  std::vector<int> v;
+  v.reserve(8);
+  v.push_back(1);
+  const auto& ref = dbg_footprint(v);
+
+  CHECK(&ref == &v);
+  CHECK_THAT(output.str(),
+             EndsWith("v: {inline: " + std::to_string(sizeof(v)) +
+                      ", used: 4, reserved: 32, slack: 28, levels: ["
+                      "{used: 4, reserved: 32, slack: 28}]} "
+                      "(std::vector<int>)"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_layout macro")
+{
+  struct record {
+    char tag;
+    int id;
+  };
+
+  SECTION("object")
+  {
+    const record r{'a', 1};
+    const auto& ref = dbg_layout(r);
+
+    CHECK(&ref == &r);
+    CHECK_THAT(output.str(),
+               ContainsSubstring("r: {size: 8, alignment: 4, fields: ["
+                                 "{offset: 0, size: 1, type: char}, "
+                                 "{padding: 3}, "
+                                 "{offset: 4, size: 4, type: int}], "
+                                 "padding: 3, address: "));
+  }
+
+  SECTION("type")
+  {
+    dbg_layout_of(std::array<record, 2>);
+
+    CHECK_THAT(output.str(),
+               EndsWith("std::array<record, 2>: {size: 16, alignment: 4} (" +
+                        jdbg::get_type_name<std::array<record, 2>>() + ")"));
+  }
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_snapshot macro")
+{
+  const std::vector<int> v{1, 2, 3};
+  const auto& ref = dbg_snapshot(v);
+  const auto& path = jdbg::snapshot_file::instance().path();
+
+  CHECK(&ref == &v);
+  CHECK_THAT(output.str(),
+             EndsWith("v: snapshot " + path +
+                      "@64 (3 x int) (const std::vector<int>)"));
+  unlink(path.c_str());
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_scope macro")
+{
+  char path[] = "/tmp/jdbg-scope-macro-XXXXXX";
+  close(mkstemp(path));
+
+  {
+    dbg_scope("outer");
+    dbg_scope("inner");
+  }
+  const auto error = jdbg::write_trace(path);
+  std::string json;
+  std::FILE* file = std::fopen(path, "rb");
+  char buf[4096];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+    json.append(buf, n);
+  }
+  std::fclose(file);
+  unlink(path);
+
+  CHECK(error == 0);
+  CHECK(output.str().empty());
+  CHECK_THAT(json, ContainsSubstring("{\"name\":\"inner\",\"cat\":\"jdbg\""));
+  CHECK_THAT(json, ContainsSubstring("jdbg_tests.cpp\",\"line\":"));
+  CHECK_THAT(json, ContainsSubstring("\"depth\":1}"));
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_perf macro")
+{
+  SECTION("value")
+  {
+    int x = 41;
+    const auto& ref = dbg_perf(x);
+    const auto val = dbg_perf(x + 1);
+
+    CHECK(&ref == &x);
+    CHECK(val == 42);
+    CHECK_THAT(output.str(), ContainsSubstring("] x: {"));
+    CHECK_THAT(output.str(), ContainsSubstring("] x + 1: {"));
+    CHECK_THAT(output.str(), EndsWith("} (int)"));
+  }
+
+  SECTION("void expression")
+  {
+    int calls = 0;
+    const auto call = [&calls] { ++calls; };
+    dbg_perf(call());
+
+    CHECK(calls == 1);
+    CHECK_THAT(output.str(), ContainsSubstring("] call(): {"));
+    CHECK_THAT(output.str(), EndsWith("} (void)"));
+  }
+
+  SECTION("sums per call site")
+  {
+    int sum = 0;
+    for (int i = 0; i < 3; ++i) {
+      sum += dbg_perf_sum(i);
+    }
+    CHECK(sum == 3);
+    CHECK(output.str().empty());
+
+    jdbg::flush();
+    CHECK_THAT(output.str(), ContainsSubstring("] i: {calls: 3"));
+    CHECK_THAT(output.str(), EndsWith("} (int)"));
+  }
+}
+
+TEST_CASE_METHOD(jdbg_tests, "dbg_mem macro")
+{
+  // The allocation hook is only part of binaries with mem_tests.cpp
+  const bool hooked = jdbg::detail::mem::hooked;
+
+  SECTION("value")
+  {
+    const auto size = dbg_mem(std::vector<int>(10).size());
+
+    CHECK(size == 10);
+    CHECK_THAT(output.str(),
+               ContainsSubstring("] std::vector<int>(10).size(): {"));
+    if (hooked) {
+      CHECK_THAT(output.str(), ContainsSubstring("{allocations: 1, frees: 1"));
+      CHECK_THAT(output.str(), EndsWith(", net: 0} (unsigned long)"));
+    } else {
+      CHECK_THAT(output.str(), EndsWith("{no allocation hook} "
+                                        "(unsigned long)"));
+    }
+  }
+
+  SECTION("sums per call site")
+  {
+    std::vector<std::unique_ptr<int>> kept;
+    for (int i = 0; i < 3; ++i) {
+      kept.push_back(dbg_mem_sum(std::make_unique<int>(i)));
+    }
+    CHECK(output.str().empty());
+
+    jdbg::flush();
+    CHECK_THAT(output.str(), ContainsSubstring("{calls: 3, sum: {"));
+    if (hooked) {
+      CHECK_THAT(output.str(), ContainsSubstring("allocations: 3, frees: 0"));
+    }
+  }
+}
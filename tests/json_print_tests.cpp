@@ -0,0 +1,184 @@
+#include <jdbg/json_print.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template <typename T>
+std::string json_print(T&& value)
+{
+  std::string buf;
+  jdbg::json_writer json{buf};
+  jdbg::json_print(json, std::forward<T>(value));
+  return buf;
+}
+
+struct my_struct {
+  int x;
+};
+
+std::ostream& operator<<(std::ostream& os, const my_struct& ms)
+{
+  os << "my_struct{" << ms.x << "}";
+  return os;
+}
+
+struct my_node {
+  const my_node* next;
+};
+
+void json_print(jdbg::json_writer& json, const my_node& node)
+{
+  json.begin_object();
+  json.key("next");
+  jdbg::json_print(json, node.next);
+  json.end_object();
+}
+
+enum class my_enum { // NOLINT
+  e1 = 13,
+};
+
+} // namespace
+
+TEST_CASE("json print")
+{
+  SECTION("primitives")
+  {
+    CHECK_THAT(json_print(true), Equals("true"));
+    CHECK_THAT(json_print('a'), Equals("\"a\""));
+    CHECK_THAT(json_print(42U), Equals("42"));
+    CHECK_THAT(json_print(-7), Equals("-7"));
+    CHECK_THAT(json_print(13.37), Equals("13.37"));
+    CHECK_THAT(json_print(0.1 + 0.2), Equals("0.30000000000000004"));
+    CHECK_THAT(json_print(std::numeric_limits<double>::quiet_NaN()),
+               Equals("\"nan\""));
+    CHECK_THAT(json_print(-std::numeric_limits<float>::infinity()),
+               Equals("\"-inf\""));
+    CHECK_THAT(json_print(my_enum::e1), Equals("13"));
+  }
+
+  SECTION("strings")
+  {
+    using namespace std::string_literals;
+    using namespace std::string_view_literals;
+    CHECK_THAT(json_print("foo"s), Equals("\"foo\""));
+    CHECK_THAT(json_print("bar"sv), Equals("\"bar\""));
+    CHECK_THAT(json_print("a\"b\\c\nd\x01"s),
+               Equals(R"("a\"b\\c\nd\u0001")"));
+    CHECK_THAT(json_print(static_cast<const char*>(nullptr)), Equals("null"));
+  }
+
+  SECTION("UTF-8")
+  {
+    using namespace std::string_literals;
+    // Valid sequences of 2, 3 and 4 bytes pass through
+    CHECK_THAT(json_print("\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"s),
+               Equals("\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\""));
+    // Latin-1, a truncated sequence, an overlong form and a surrogate
+    CHECK_THAT(json_print("caf\xe9"s), Equals(R"("caf\ufffd")"));
+    CHECK_THAT(json_print("\xe2\x82"s), Equals(R"("\ufffd\ufffd")"));
+    CHECK_THAT(json_print("\xc0\xafx"s), Equals(R"("\ufffd\ufffdx")"));
+    CHECK_THAT(json_print("\xed\xa0\x80"s),
+               Equals(R"("\ufffd\ufffd\ufffd")"));
+  }
+
+  SECTION("pointers")
+  {
+    const int i = 10;
+    CHECK_THAT(json_print(&i), StartsWith("{\"address\":\"0x"));
+    CHECK_THAT(json_print(&i), EndsWith("\",\"value\":10}"));
+    CHECK_THAT(json_print(std::unique_ptr<int>{}), Equals("null"));
+    const auto ptr = std::make_shared<std::string>("qwe");
+    CHECK_THAT(json_print(ptr), EndsWith("\"value\":\"qwe\"},\"refs\":1}"));
+  }
+
+  SECTION("pointer cycles")
+  {
+    my_node node{nullptr};
+    node.next = &node;
+    CHECK_THAT(json_print(&node), StartsWith("{\"address\":\"0x"));
+    CHECK_THAT(json_print(&node), EndsWith("\"cycle\":true}}}"));
+  }
+
+  SECTION("containers")
+  {
+    CHECK_THAT(json_print(std::vector<int>{}), Equals("[]"));
+    CHECK_THAT(
+        json_print(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}),
+        Equals("[1,2,3,4,5,6,7,8,9,10,11]"));
+    const std::map<int, std::vector<std::string>> m{
+        {1, {"a", "b"}},
+        {2, {}},
+    };
+    CHECK_THAT(json_print(m), Equals(R"([[1,["a","b"]],[2,[]]])"));
+  }
+
+  SECTION("std::tuple")
+  {
+    CHECK_THAT(json_print(std::tuple<>{}), Equals("[]"));
+    CHECK_THAT(json_print(std::tuple<int, std::string, std::pair<int, bool>>{
+                   1, "one", {2, false}}),
+               Equals(R"([1,"one",[2,false]])"));
+  }
+
+  SECTION("std::optional")
+  {
+    CHECK_THAT(json_print(std::optional<int>{}), Equals("null"));
+    CHECK_THAT(json_print(std::optional<std::string>{"asd"}),
+               Equals("\"asd\""));
+  }
+
+  SECTION("std::variant")
+  {
+    const std::variant<int, double, std::string> var{"foo"};
+    CHECK_THAT(json_print(var), Equals(R"({"index":2,"value":"foo"})"));
+  }
+
+  SECTION("user defined type")
+  {
+    CHECK_THAT(json_print(my_struct{9001}), Equals("\"my_struct{9001}\""));
+  }
+}
+
+TEST_CASE("is_json_object")
+{
+  using jdbg::detail::is_json_object;
+  using namespace std::string_literals;
+
+  CHECK(is_json_object("{}"));
+  CHECK(is_json_object(R"( {"a":[1,-2.5e3,true,null,{"b":"é\n"}]} )"));
+  CHECK(is_json_object("{\"caf\xc3\xa9\":0}"));
+
+  // Text records, other values and broken objects
+  CHECK_FALSE(is_json_object("[file.cpp:1 (f)] x = 1"));
+  CHECK_FALSE(is_json_object(R"([{"a":1}])"));
+  CHECK_FALSE(is_json_object(R"("a")"));
+  CHECK_FALSE(is_json_object(R"({"a":1)"));
+  CHECK_FALSE(is_json_object(R"({"a":1} x)"));
+  CHECK_FALSE(is_json_object(R"({"a":1,})"));
+  CHECK_FALSE(is_json_object(R"({a:1})"));
+  CHECK_FALSE(is_json_object(R"({"a":01})"));
+  CHECK_FALSE(is_json_object(R"({"a":"\x"})"));
+  CHECK_FALSE(is_json_object("{\"a\":\"\n\"}"));
+  CHECK_FALSE(is_json_object("{\"caf\xe9\":0}"s));
+  // Nesting past the limit
+  CHECK_FALSE(is_json_object(R"({"a":)" + std::string(100, '[') +
+                             std::string(100, ']') + "}"));
+}
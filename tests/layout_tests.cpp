@@ -0,0 +1,178 @@
+#include <jdbg/layout.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+struct padded {
+  char a;
+  double b;
+  int c;
+};
+
+struct reordered {
+  double b;
+  int c;
+  char a;
+};
+
+struct straddling {
+  std::array<char, 60> head;
+  std::array<char, 8> tail;
+};
+
+struct nested {
+  padded inner;
+  std::string name;
+};
+
+struct empty {};
+
+class not_aggregate {
+public:
+  explicit not_aggregate(int val) : val_{val} {}
+
+private:
+  int val_;
+};
+
+} // namespace
+
+TEST_CASE("layout_of")
+{
+  SECTION("padding holes")
+  {
+    const auto layout = jdbg::layout_of<padded>();
+    CHECK(layout.size == sizeof(padded));
+    CHECK(layout.alignment == alignof(padded));
+    CHECK(layout.is_decomposed);
+    REQUIRE(layout.fields.size() == 3);
+    CHECK(layout.fields[0].type == "char");
+    CHECK(layout.fields[0].offset == 0);
+    CHECK(layout.fields[1].type == "double");
+    CHECK(layout.fields[1].offset == alignof(double));
+    CHECK(layout.fields[1].padding_before == alignof(double) - 1);
+    CHECK(layout.fields[2].type == "int");
+    CHECK(layout.fields[2].offset == 2 * alignof(double));
+    CHECK(layout.fields[2].size == sizeof(int));
+    CHECK(layout.tail_padding ==
+          sizeof(padded) - 2 * alignof(double) - sizeof(int));
+    CHECK(layout.address == nullptr);
+  }
+
+  SECTION("reordered fields")
+  {
+    const auto layout = jdbg::layout_of<reordered>();
+    REQUIRE(layout.fields.size() == 3);
+    CHECK(layout.padding() < jdbg::layout_of<padded>().padding());
+    CHECK(layout.padding() == sizeof(reordered) - sizeof(double) -
+                                  sizeof(int) - sizeof(char));
+  }
+
+  SECTION("cache lines")
+  {
+    const auto layout = jdbg::layout_of<straddling>();
+    REQUIRE(layout.fields.size() == 2);
+    CHECK_FALSE(layout.fields[0].straddles_cache_line);
+    CHECK(layout.fields[1].offset == 60);
+    CHECK(layout.fields[1].straddles_cache_line);
+  }
+
+  SECTION("nested")
+  {
+    const auto layout = jdbg::layout_of<nested>();
+    REQUIRE(layout.fields.size() == 2);
+    CHECK(layout.fields[0].type == jdbg::get_type_name<padded>());
+    CHECK(layout.fields[0].size == sizeof(padded));
+    CHECK(layout.fields[1].type == "std::string");
+    CHECK(layout.fields[1].offset == sizeof(padded));
+  }
+
+  SECTION("not decomposed")
+  {
+    const auto empty_layout = jdbg::layout_of<empty>();
+    CHECK(empty_layout.is_decomposed);
+    CHECK(empty_layout.fields.empty());
+
+    const auto layout = jdbg::layout_of<not_aggregate>();
+    CHECK(layout.size == sizeof(int));
+    CHECK_FALSE(layout.is_decomposed);
+    CHECK(layout.fields.empty());
+    CHECK_FALSE(jdbg::layout_of<std::array<int, 4>>().is_decomposed);
+    CHECK_FALSE(jdbg::layout_of<int>().is_decomposed);
+  }
+
+  SECTION("object")
+  {
+    alignas(64) const straddling val{};
+    const auto layout = jdbg::layout_of(val);
+    CHECK(layout.address == &val);
+    CHECK(layout.address_alignment() >= 64);
+    CHECK(layout.address_alignment() % 64 == 0);
+    REQUIRE(layout.fields.size() == 2);
+    CHECK(layout.fields[1].type == "std::array<char, 8>");
+    CHECK(layout.fields[1].straddles_cache_line);
+
+    alignas(64) const std::array<straddling, 2> pair{};
+    const auto second = jdbg::layout_of(pair[1]);
+    CHECK(second.address_alignment() == 4);
+    CHECK_FALSE(second.fields[0].straddles_cache_line);
+    CHECK_FALSE(second.fields[1].straddles_cache_line);
+  }
+}
+
+TEST_CASE("type_layout printing")
+{
+  jdbg::type_layout layout;
+  layout.size = 72;
+  layout.alignment = 8;
+  layout.is_decomposed = true;
+  layout.fields.push_back({"char", 0, 1, 0, false});
+  layout.fields.push_back({"long", 60, 8, 59, true});
+  layout.tail_padding = 4;
+
+  SECTION("pretty_print")
+  {
+    std::ostringstream os;
+    jdbg::pretty_print(os, layout);
+    CHECK_THAT(os.str(),
+               Equals("{size: 72, alignment: 8, fields: ["
+                      "{offset: 0, size: 1, type: char}, {padding: 59}, "
+                      "{offset: 60, size: 8, type: long, "
+                      "straddles cache line}, {padding: 4}], padding: 63}"));
+  }
+
+  SECTION("pretty_print address")
+  {
+    layout.is_decomposed = false;
+    layout.address = reinterpret_cast<const void*>(0x1040);
+    std::ostringstream os;
+    jdbg::pretty_print(os, layout);
+    CHECK_THAT(os.str(), Equals("{size: 72, alignment: 8, address: 0x1040, "
+                                "address alignment: 64}"));
+  }
+
+  SECTION("json_print")
+  {
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, layout);
+    CHECK_THAT(buf, Equals(R"({"size":72,"alignment":8,"fields":[)"
+                           R"({"type":"char","offset":0,"size":1,)"
+                           R"("padding_before":0,)"
+                           R"("straddles_cache_line":false},)"
+                           R"({"type":"long","offset":60,"size":8,)"
+                           R"("padding_before":59,)"
+                           R"("straddles_cache_line":true}],)"
+                           R"("tail_padding":4,"padding":63})"));
+  }
+}
@@ -0,0 +1,115 @@
+#include <jdbg/mem.hpp>
+#include <jdbg/mem_hook.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template <typename T>
+std::string print(const T& val)
+{
+  std::ostringstream os;
+  jdbg::pretty_print(os, val);
+  return os.str();
+}
+
+struct alignas(64) cache_line {
+  char bytes[64];
+};
+
+} // namespace
+
+TEST_CASE("allocation hook")
+{
+  using jdbg::detail::mem::difference;
+  using jdbg::detail::mem::read;
+
+  SECTION("installed")
+  {
+    CHECK(read().hooked);
+  }
+
+  SECTION("balanced")
+  {
+    const auto before = read();
+    {
+      const std::vector<int> v(100);
+      const auto p = std::make_unique<cache_line>();
+      const auto a = std::make_unique<int[]>(3);
+    }
+    const auto sample = difference(before, read());
+
+    CHECK(sample.allocations == 3);
+    CHECK(sample.frees == 3);
+    CHECK(sample.allocated >= 100 * sizeof(int) + sizeof(cache_line));
+    CHECK(sample.net() == 0);
+  }
+
+  SECTION("net growth")
+  {
+    const auto before = read();
+    auto* leaked = new char[200];
+    const auto sample = difference(before, read());
+    delete[] leaked;
+
+    CHECK(sample.allocations == 1);
+    CHECK(sample.frees == 0);
+    CHECK(sample.net() >= 200);
+  }
+
+  SECTION("nothrow")
+  {
+    const auto before = read();
+    auto* p = new (std::nothrow) int{7};
+    delete p;
+    const auto sample = difference(before, read());
+
+    CHECK(sample.allocations == 1);
+    CHECK(sample.frees == 1);
+  }
+
+  SECTION("paused")
+  {
+    const auto before = read();
+    {
+      const jdbg::detail::mem::pause no_count;
+      const std::string s(100, 'x');
+    }
+    const auto sample = difference(before, read());
+
+    CHECK(sample.allocations == 0);
+    CHECK(sample.frees == 0);
+  }
+}
+
+TEST_CASE("allocation printing")
+{
+  jdbg::mem_sample sample;
+  CHECK(print(sample) == "{no allocation hook}");
+
+  sample = {true, 2, 1, 96, 32};
+  CHECK(print(sample) ==
+        "{allocations: 2, frees: 1, allocated: 96, freed: 32, net: 64}");
+
+  std::string json;
+  jdbg::json_writer writer{json};
+  jdbg::json_print(writer, sample);
+  CHECK(json == "{\"hooked\":true,\"allocations\":2,\"frees\":1,"
+                "\"allocated\":96,\"freed\":32,\"net\":64}");
+
+  jdbg::mem_totals totals;
+  totals.add(sample);
+  totals.add({true, 1, 2, 32, 96});
+  CHECK(print(totals) == "{calls: 2, sum: {allocations: 3, frees: 3, "
+                         "allocated: 128, freed: 128, net: 0}}");
+}
@@ -0,0 +1,112 @@
+#define JDBG_NO_IOSTREAM
+#define JDBG_LOG_FUNCTION(str) captured += (str)
+#define JDBG_IS_OUTPUT_COLOURED (false)
+
+#include <string>
+
+namespace {
+std::string captured; // NOLINT
+} // namespace
+
+#include <jdbg/jdbg.hpp>
+
+#ifdef _GLIBCXX_IOSTREAM
+#error "jdbg.hpp must not include <iostream> with JDBG_NO_IOSTREAM"
+#endif
+#ifdef _GLIBCXX_SSTREAM
+#error "jdbg.hpp must not include <sstream> with JDBG_NO_IOSTREAM"
+#endif
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template <typename T>
+std::string pretty_print(T&& value)
+{
+  jdbg::detail::text_stream ts;
+  jdbg::pretty_print(ts, std::forward<T>(value));
+  return ts.str();
+}
+
+struct my_struct {
+  int x;
+  std::vector<int> v;
+};
+
+std::ostream& operator<<(std::ostream& os, const my_struct& ms)
+{
+  os << "my_struct{" << ms.x << ", ";
+  jdbg::pretty_print(os, ms.v);
+  return os << "}";
+}
+
+} // namespace
+
+TEST_CASE("pretty print without iostream")
+{
+  SECTION("primitives")
+  {
+    CHECK_THAT(pretty_print(true), Equals("true"));
+    CHECK_THAT(pretty_print('a'), Equals("0x61"));
+    CHECK_THAT(pretty_print(42U), Equals("42"));
+    CHECK_THAT(pretty_print(-42L), Equals("-42"));
+    CHECK_THAT(pretty_print(13.37), Equals("13.37"));
+    CHECK_THAT(pretty_print(1.0 / 3), Equals("0.333333"));
+    CHECK_THAT(pretty_print(1e20), Equals("1e+20"));
+    CHECK_THAT(pretty_print(std::pair{'a', 42}), Equals("(0x61, 42)"));
+  }
+
+  SECTION("pointers")
+  {
+    const double d = 90.01;
+    CHECK_THAT(pretty_print(static_cast<void*>(nullptr)), Equals("nullptr"));
+    CHECK_THAT(pretty_print(&d), StartsWith("0x"));
+    CHECK_THAT(pretty_print(&d), EndsWith(" -> 90.01"));
+    CHECK_THAT(pretty_print(std::make_shared<int>(1)), EndsWith("(refs: 1)"));
+  }
+
+  SECTION("std types")
+  {
+    using namespace std::string_view_literals;
+    CHECK_THAT(pretty_print("bar"sv), Equals("\"bar\""));
+    CHECK_THAT(pretty_print(std::vector<int>{1, 2, 3}), Equals("[1, 2, 3]"));
+    CHECK_THAT(pretty_print(std::map<int, std::string>{{1, "a"}}),
+               Equals("[(1, \"a\")]"));
+    CHECK_THAT(pretty_print(std::tuple{1, std::optional<int>{}}),
+               Equals("(1, nullopt)"));
+    CHECK_THAT(pretty_print(std::variant<int, std::string>{"x"}),
+               Equals("{\"x\"}"));
+  }
+
+  SECTION("user defined type")
+  {
+    CHECK_THAT(pretty_print(my_struct{1, {2, 3}}),
+               Equals("my_struct{1, [2, 3]}"));
+  }
+}
+
+TEST_CASE("dbg macro without iostream")
+{
+  captured.clear();
+  const std::vector<int> v{1, 2};
+  const auto& ref = dbg(v);
+
+  CHECK(&ref == &v);
+  CHECK_THAT(captured, StartsWith("[no_iostream_tests.cpp:"));
+  CHECK_THAT(captured, EndsWith("v: [1, 2] (const std::vector<int>)"));
+}
@@ -0,0 +1,105 @@
+#include <jdbg/perf.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::size_t index_of(const std::string& name)
+{
+  for (std::size_t i = 0; i < jdbg::detail::perf::counter_count; ++i) {
+    if (name == jdbg::detail::perf::counters[i].name) {
+      return i;
+    }
+  }
+  return jdbg::detail::perf::counter_count;
+}
+
+template <typename T>
+std::string print(const T& val)
+{
+  std::ostringstream os;
+  jdbg::pretty_print(os, val);
+  return os.str();
+}
+
+} // namespace
+
+TEST_CASE("perf counters")
+{
+  SECTION("measure")
+  {
+    std::vector<std::uint64_t> v(1 << 16, 1);
+    std::uint64_t sum = 0;
+    const auto sample = jdbg::measure_perf([&] {
+      for (const auto x : v) {
+        sum += x;
+      }
+    });
+    CHECK(sum == v.size());
+
+    // perf_event_open() is not available in every container
+    const auto cycles = index_of("cycles");
+    const auto task_clock = index_of("task-clock");
+    if ((sample.counters & (1U << cycles)) != 0) {
+      CHECK(sample.values[cycles] > 0);
+    } else if ((sample.counters & (1U << task_clock)) != 0) {
+      CHECK(sample.values[task_clock] > 0);
+    } else {
+      CHECK(sample.counters == 0);
+    }
+  }
+
+  SECTION("printing")
+  {
+    jdbg::perf_sample sample;
+    CHECK(print(sample) == "{no perf counters}");
+
+    sample.counters = (1U << index_of("cycles")) |
+                      (1U << index_of("branch-misses"));
+    sample.values[index_of("cycles")] = 1200;
+    sample.values[index_of("branch-misses")] = 3;
+    sample.values[index_of("instructions")] = 99;
+    CHECK(print(sample) == "{cycles: 1200, branch-misses: 3}");
+
+    std::string json;
+    jdbg::json_writer writer{json};
+    jdbg::json_print(writer, sample);
+    CHECK(json == "{\"cycles\":1200,\"branch-misses\":3}");
+  }
+
+  SECTION("totals")
+  {
+    const auto page_faults = index_of("page-faults");
+    const auto task_clock = index_of("task-clock");
+    jdbg::perf_sample first;
+    first.counters = (1U << page_faults) | (1U << task_clock);
+    first.values[page_faults] = 1;
+    first.values[task_clock] = 100;
+    jdbg::perf_sample second;
+    second.counters = 1U << task_clock;
+    second.values[task_clock] = 200;
+
+    jdbg::perf_totals totals;
+    CHECK(print(totals) == "{calls: 0}");
+    totals.add(first);
+    totals.add(second);
+
+    CHECK(totals.calls == 2);
+    CHECK(print(totals) == "{calls: 2, mean: {task-clock: 150}}");
+
+    std::string json;
+    jdbg::json_writer writer{json};
+    jdbg::json_print(writer, totals);
+    CHECK(json == "{\"calls\":2,\"sum\":{\"task-clock\":300}}");
+  }
+}
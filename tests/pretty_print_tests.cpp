@@ -44,6 +44,19 @@ enum class my_enum { // NOLINT
   e2 = 37,
 };
 
+struct my_node {
+  int value;
+  const my_node* next;
+  const my_node* prev;
+};
+
+std::ostream& operator<<(std::ostream& os, const my_node& node)
+{
+  os << "node{" << node.value << ", ";
+  jdbg::pretty_print(os, node.next);
+  return os << "}";
+}
+
 template <typename T, std::size_t N>
 struct my_container {
   T data[N];
@@ -62,6 +75,7 @@ TEST_CASE("pretty print")
     CHECK_THAT(pretty_print('a'), Equals("0x61"));
     CHECK_THAT(pretty_print(42U), Equals("42"));
     CHECK_THAT(pretty_print(13.37), Equals("13.37"));
+    CHECK_THAT(pretty_print(std::pair{'a', 42}), Equals("(0x61, 42)"));
   }
 
   SECTION("pointers")
@@ -80,6 +94,37 @@ TEST_CASE("pretty print")
     CHECK_THAT(pretty_print(&test_d), EndsWith("-> 90.01"));
   }
 
+  SECTION("pointer cycles")
+  {
+    my_node a{1, nullptr, nullptr};
+    my_node b{2, nullptr, &a};
+    a.next = &b;
+    b.next = &a;
+    const auto addr_a = pretty_print(static_cast<const void*>(&a));
+    const auto addr_b = pretty_print(static_cast<const void*>(&b));
+
+    CHECK_THAT(pretty_print(&a),
+               Equals(addr_a + " -> node{1, " + addr_b +
+                      " -> node{2, <cycle -> " + addr_a + ">}}"));
+  }
+
+  SECTION("pointer depth limit")
+  {
+    std::vector<my_node> chain(32, my_node{0, nullptr, nullptr});
+    for (std::size_t i = 0; i + 1 < chain.size(); ++i) {
+      chain[i].next = &chain[i + 1];
+    }
+    const auto out = pretty_print(chain.data());
+
+    std::size_t nodes = 0;
+    for (auto pos = out.find("node{"); pos != std::string::npos;
+         pos = out.find("node{", pos + 1)) {
+      ++nodes;
+    }
+    CHECK(nodes == JDBG_MAX_POINTER_DEPTH);
+    CHECK_THAT(out, ContainsSubstring(" -> ...}"));
+  }
+
   SECTION("std::string")
   {
     using namespace std::string_literals;
@@ -0,0 +1,165 @@
+#include <jdbg/scope.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+class temp_path {
+public:
+  temp_path() { close(mkstemp(path_)); }
+
+  ~temp_path() { unlink(path_); }
+
+  temp_path(const temp_path&) = delete;
+  temp_path& operator=(const temp_path&) = delete;
+
+  const char* get() const { return path_; }
+
+  std::string read() const
+  {
+    std::string content;
+    std::FILE* file = std::fopen(path_, "rb");
+    char buf[4096];
+    std::size_t n = 0;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+      content.append(buf, n);
+    }
+    std::fclose(file);
+    return content;
+  }
+
+private:
+  char path_[32] = "/tmp/jdbg-scope-tests-XXXXXX";
+};
+
+std::size_t count(const std::string& str, const std::string& sub)
+{
+  std::size_t n = 0;
+  for (auto pos = str.find(sub); pos != std::string::npos;
+       pos = str.find(sub, pos + 1)) {
+    ++n;
+  }
+  return n;
+}
+
+} // namespace
+
+TEST_CASE("trace scopes")
+{
+  using jdbg::detail::trace::registry;
+  using jdbg::detail::trace::scope;
+  using jdbg::detail::trace::site;
+
+  const temp_path at_exit;
+  const temp_path trace;
+  registry reg{at_exit.get()};
+
+  SECTION("nested spans")
+  {
+    auto& buffer = *reg.add();
+    {
+      static const site outer_site{"outer", "a.cpp", 1, "f"};
+      static const site inner_site{"inner", "a.cpp", 2, "f"};
+      const scope outer{outer_site, buffer};
+      const scope inner{inner_site, buffer};
+    }
+    REQUIRE(reg.write(trace.get()) == 0);
+    const auto json = trace.read();
+
+    CHECK_THAT(json, StartsWith("{\"traceEvents\":[{\"name\":\"inner\","
+                                "\"cat\":\"jdbg\",\"ph\":\"X\",\"ts\":"));
+    CHECK_THAT(json, ContainsSubstring("\"args\":{\"file\":\"a.cpp\","
+                                       "\"line\":2,\"func\":\"f\","
+                                       "\"depth\":1}"));
+    CHECK_THAT(json, ContainsSubstring("\"name\":\"outer\""));
+    CHECK_THAT(json, ContainsSubstring("\"depth\":0}"));
+    CHECK_THAT(json, EndsWith("],\"displayTimeUnit\":\"ns\","
+                              "\"otherData\":{\"dropped\":0}}\n"));
+  }
+
+  SECTION("threads and blocks")
+  {
+    constexpr std::size_t spans = 3 * jdbg::detail::trace::block_spans + 5;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+      threads.emplace_back([&reg] {
+        static const site work{"work", "b.cpp", 3, "g"};
+        auto& buffer = *reg.add();
+        for (std::size_t i = 0; i < spans; ++i) {
+          const scope span{work, buffer};
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(reg.write(trace.get()) == 0);
+
+    CHECK(count(trace.read(), "\"name\":\"work\"") == 3 * spans);
+  }
+
+  SECTION("only new spans are written")
+  {
+    static const site first_site{"first", "c.cpp", 4, "h"};
+    static const site second_site{"second", "c.cpp", 5, "h"};
+    auto& buffer = *reg.add();
+    {
+      const scope first{first_site, buffer};
+    }
+    REQUIRE(reg.write(trace.get()) == 0);
+    {
+      const scope second{second_site, buffer};
+    }
+    REQUIRE(reg.write(trace.get()) == 0);
+    const auto json = trace.read();
+
+    CHECK_THAT(json, ContainsSubstring("\"name\":\"second\""));
+    CHECK(count(json, "\"name\":") == 1);
+  }
+
+  SECTION("exit keeps a trace written to the same path")
+  {
+    static const site first_site{"first", "d.cpp", 6, "k"};
+    static const site second_site{"second", "d.cpp", 7, "k"};
+    {
+      registry own{trace.get()};
+      auto& buffer = *own.add();
+      {
+        const scope first{first_site, buffer};
+      }
+      REQUIRE(own.write(trace.get()) == 0);
+      {
+        const scope second{second_site, buffer};
+      }
+    }
+    const auto json = trace.read();
+
+    CHECK_THAT(json, ContainsSubstring("\"name\":\"first\""));
+    CHECK_THAT(json, ContainsSubstring("\"name\":\"second\""));
+  }
+
+  SECTION("no spans after closing")
+  {
+    static const site late_site{"late", "e.cpp", 8, "m"};
+    auto& buffer = *reg.add();
+    reg.close();
+    {
+      const scope late{late_site, buffer};
+    }
+    REQUIRE(reg.write(trace.get()) == 0);
+
+    CHECK(count(trace.read(), "\"name\":") == 0);
+  }
+}
@@ -0,0 +1,314 @@
+#include <jdbg/shm_sink.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct local_ring {
+  explicit local_ring(std::size_t size) : data(size, '\0') {}
+
+  jdbg::detail::shm::ring view() { return {head, data.data(), data.size()}; }
+
+  jdbg::detail::shm::ring_header head{};
+  std::vector<char> data;
+};
+
+std::vector<std::string> drain_texts(jdbg::detail::shm::ring ring)
+{
+  std::vector<std::string> texts;
+  ring.drain([&](std::uint64_t /*time*/, std::string_view text) {
+    texts.emplace_back(text);
+  });
+  return texts;
+}
+
+std::string segment_name()
+{
+  return "/jdbg-tests-" + std::to_string(getpid());
+}
+
+// Runs fn in a child process, returns the pid and the exit status
+template <typename Fn>
+std::pair<pid_t, int> in_child(Fn&& fn)
+{
+  const auto pid = fork();
+  if (pid == 0) {
+    _exit(fn());
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return {pid, status};
+}
+
+std::size_t claimed_rings(const char* name)
+{
+  const jdbg::detail::shm::segment seg{name, 0, 0};
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < seg.rings(); ++i) {
+    count += seg.at(i).head().pid.load() != 0 ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace
+
+TEST_CASE("shm ring")
+{
+  local_ring mem{4096};
+  auto ring = mem.view();
+
+  SECTION("order")
+  {
+    CHECK(ring.push(1, "first"));
+    CHECK(ring.push(2, ""));
+    CHECK(ring.push(3, "third"));
+
+    std::vector<std::uint64_t> times;
+    std::vector<std::string> texts;
+    CHECK(ring.drain([&](std::uint64_t time, std::string_view text) {
+      times.push_back(time);
+      texts.emplace_back(text);
+    }) == 3);
+    CHECK(times == std::vector<std::uint64_t>{1, 2, 3});
+    CHECK(texts == std::vector<std::string>{"first", "", "third"});
+    CHECK(ring.is_empty());
+    CHECK(drain_texts(ring).empty());
+  }
+
+  SECTION("wrap around")
+  {
+    // Sizes that do not divide the ring, so records hit its end
+    for (int round = 0; round < 200; ++round) {
+      const std::string a(static_cast<std::size_t>(round % 97), 'a');
+      const std::string b = std::to_string(round);
+      REQUIRE(ring.push(0, a));
+      REQUIRE(ring.push(0, b));
+      CHECK(drain_texts(ring) == std::vector<std::string>{a, b});
+    }
+  }
+
+  SECTION("full")
+  {
+    const std::string text(100, 'x');
+    std::size_t pushed = 0;
+    while (ring.push(0, text)) {
+      ++pushed;
+    }
+    CHECK(pushed == 4096 / 120);
+    CHECK(drain_texts(ring).size() == pushed);
+    CHECK(ring.push(0, text));
+  }
+
+  SECTION("too long")
+  {
+    CHECK_FALSE(ring.push(0, std::string(4096 / 4, 'x')));
+  }
+
+  SECTION("unfinished record")
+  {
+    CHECK(ring.push(0, "done"));
+    mem.head.reserved += 64;
+    CHECK(ring.push(0, "after"));
+
+    CHECK(drain_texts(ring) == std::vector<std::string>{"done"});
+    CHECK(ring.discard() == 64 + 24);
+    CHECK(ring.is_empty());
+    CHECK(ring.push(0, "again"));
+    CHECK(drain_texts(ring) == std::vector<std::string>{"again"});
+  }
+
+  SECTION("concurrent writers")
+  {
+    constexpr int per_thread = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&ring, t] {
+        for (int i = 0; i < per_thread;) {
+          if (ring.push(static_cast<std::uint64_t>(t),
+                        std::to_string(t * per_thread + i))) {
+            ++i;
+          }
+        }
+      });
+    }
+    std::vector<int> seen(4 * per_thread, 0);
+    std::size_t total = 0;
+    while (total < seen.size()) {
+      total += ring.drain([&](std::uint64_t, std::string_view text) {
+        ++seen[static_cast<std::size_t>(std::stoi(std::string{text}))];
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    CHECK(std::count(seen.begin(), seen.end(), 1) ==
+          static_cast<std::ptrdiff_t>(seen.size()));
+  }
+}
+
+TEST_CASE("shm_sink")
+{
+  const auto name = segment_name();
+  jdbg::shm_sink::remove(name.c_str());
+
+  SECTION("collect")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    REQUIRE(sink.is_open());
+    jdbg::shm_collector collector{name.c_str()};
+    REQUIRE(collector.is_open());
+
+    sink.write("a");
+    sink.write("b");
+    std::vector<jdbg::shm_record> records;
+    CHECK(collector.drain(records) == 2);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].pid == getpid());
+    CHECK(records[0].text == "a");
+    CHECK(records[1].text == "b");
+    CHECK(records[0].time <= records[1].time);
+  }
+
+  SECTION("dropped")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    jdbg::shm_collector collector{name.c_str()};
+    for (int i = 0; i < 100; ++i) {
+      sink.write(std::string(100, 'x'));
+    }
+    CHECK(sink.dropped() == 100 - 4096 / 120);
+
+    std::vector<jdbg::shm_record> records;
+    collector.drain(records);
+    REQUIRE_FALSE(records.empty());
+    CHECK(records.back().text == "jdbg: " +
+                                     std::to_string(sink.dropped()) +
+                                     " records dropped");
+    CHECK(records.back().is_note);
+    CHECK_FALSE(records.front().is_note);
+
+    // Notes are plain text, quoted unlike the records
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, records.back());
+    CHECK(buf == R"({"pid":)" + std::to_string(getpid()) + R"(,"time":)" +
+                     std::to_string(records.back().time) +
+                     R"(,"note":"jdbg: )" + std::to_string(sink.dropped()) +
+                     R"( records dropped"})");
+  }
+
+  SECTION("json records")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    jdbg::shm_collector collector{name.c_str()};
+    sink.write(R"({"value":1})");
+    std::vector<jdbg::shm_record> records;
+    collector.drain(records);
+    REQUIRE(records.size() == 1);
+
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, records[0]);
+    CHECK(buf == R"({"pid":)" + std::to_string(getpid()) + R"(,"time":)" +
+                     std::to_string(records[0].time) +
+                     R"(,"record":{"value":1}})");
+  }
+
+  SECTION("text records as json")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    jdbg::shm_collector collector{name.c_str()};
+    sink.write("[file.cpp:1 (f)] x = \"1\"");
+    sink.write(R"({"value":1)");
+    std::vector<jdbg::shm_record> records;
+    collector.drain(records);
+    REQUIRE(records.size() == 2);
+
+    std::vector<std::string> lines;
+    for (const auto& rec : records) {
+      jdbg::json_writer json{lines.emplace_back()};
+      jdbg::json_print(json, rec);
+      CHECK(jdbg::detail::is_json_object(lines.back()));
+    }
+    CHECK(lines[0] == R"({"pid":)" + std::to_string(getpid()) +
+                          R"(,"time":)" + std::to_string(records[0].time) +
+                          R"(,"record":"[file.cpp:1 (f)] x = \"1\""})");
+    CHECK(lines[1].find(R"("record":"{\"value\":1"})") !=
+          std::string::npos);
+  }
+
+  SECTION("fork")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    jdbg::shm_collector collector{name.c_str()};
+    sink.write("parent");
+    const auto child = in_child([&] {
+      sink.write("child");
+      return 0;
+    });
+
+    std::vector<jdbg::shm_record> records;
+    collector.drain(records);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].pid == getpid());
+    CHECK(records[0].text == "parent");
+    CHECK(records[1].pid == child.first);
+    CHECK(records[1].text == "child");
+    // The ring of the child is free again once read
+    CHECK(claimed_rings(name.c_str()) == 1);
+  }
+
+  SECTION("crash")
+  {
+    jdbg::shm_sink sink{name.c_str(), 4, 4096};
+    jdbg::shm_collector collector{name.c_str()};
+    const auto child = in_child([&] {
+      sink.write("before");
+      // Dies with a record reserved but not written
+      const jdbg::detail::shm::segment seg{name.c_str(), 0, 0};
+      for (std::size_t i = 0; i < seg.rings(); ++i) {
+        auto& head = seg.at(i).head();
+        if (head.pid == getpid()) {
+          head.reserved += 64;
+        }
+      }
+      sink.write("after");
+      raise(SIGKILL);
+      return 0;
+    });
+    CHECK(WIFSIGNALED(child.second));
+
+    std::vector<jdbg::shm_record> records;
+    collector.drain(records);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].pid == child.first);
+    CHECK(records[0].text == "before");
+    CHECK(records[1].text == "jdbg: 88 bytes of unfinished records dropped");
+    CHECK(claimed_rings(name.c_str()) == 1);
+  }
+
+  SECTION("rings of exited processes")
+  {
+    jdbg::shm_sink sink{name.c_str(), 2, 4096};
+    // Without a collector, the single spare ring is taken over by every
+    // child as the one before left it empty
+    for (int i = 0; i < 5; ++i) {
+      const auto child = in_child([&] { return sink.is_open() ? 0 : 1; });
+      CHECK(WEXITSTATUS(child.second) == 0);
+    }
+  }
+
+  jdbg::shm_sink::remove(name.c_str());
+}
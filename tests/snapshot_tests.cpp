@@ -0,0 +1,170 @@
+#include <jdbg/snapshot.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+struct point {
+  float x;
+  float y;
+};
+
+std::string read_file(const char* path)
+{
+  std::string content;
+  std::FILE* file = std::fopen(path, "rb");
+  char buf[4096];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+    content.append(buf, n);
+  }
+  std::fclose(file);
+  return content;
+}
+
+} // namespace
+
+TEST_CASE("snapshot")
+{
+  char path[] = "/tmp/jdbg-snapshot-tests-XXXXXX";
+  close(mkstemp(path));
+
+  std::vector<double> doubles(1000);
+  for (std::size_t i = 0; i < doubles.size(); ++i) {
+    doubles[i] = 0.1 * static_cast<double>(i);
+  }
+  const std::array<point, 2> points{{{1, 2}, {3, 4}}};
+  const std::vector<std::uint8_t> empty;
+
+  std::vector<jdbg::snapshot_ref> refs;
+  {
+    jdbg::snapshot_file file{path};
+    refs.push_back(file.append("double", sizeof(double), doubles.size(),
+                               doubles.data()));
+    refs.push_back(file.append(jdbg::get_type_name<point>(), sizeof(point),
+                               points.size(), points.data()));
+    refs.push_back(file.append("unsigned char", 1, 0, empty.data()));
+  }
+  const auto data = read_file(path);
+  unlink(path);
+
+  SECTION("refs")
+  {
+    for (const auto& ref : refs) {
+      CHECK(ref.error == 0);
+      CHECK(ref.path == path);
+      CHECK(ref.offset % 64 == 0);
+    }
+    CHECK(refs[0].offset == 64);
+    CHECK(refs[0].count == 1000);
+    CHECK(refs[0].element_size == sizeof(double));
+    CHECK(refs[1].offset > refs[0].offset + 8000);
+    CHECK(data.size() % 64 == 0);
+  }
+
+  SECTION("read in order")
+  {
+    jdbg::snapshot_reader reader{data};
+    jdbg::snapshot_view view;
+
+    REQUIRE(reader.next(view));
+    CHECK(view.offset == refs[0].offset);
+    CHECK(view.type == "double");
+    CHECK(view.count == doubles.size());
+    CHECK(view.is_native());
+    REQUIRE(view.as<double>() != nullptr);
+    CHECK(std::memcmp(view.as<double>(), doubles.data(), view.bytes()) == 0);
+    CHECK(view.as<float>() == nullptr);
+    CHECK(view.as<std::int64_t>() == nullptr);
+
+    REQUIRE(reader.next(view));
+    REQUIRE(view.as<point>() != nullptr);
+    CHECK(view.as<point>()[1].y == 4);
+
+    REQUIRE(reader.next(view));
+    CHECK(view.count == 0);
+    CHECK(view.type == "unsigned char");
+
+    CHECK_FALSE(reader.next(view));
+    CHECK(reader.state() == jdbg::snapshot_reader::status::end);
+  }
+
+  SECTION("read at offset")
+  {
+    const jdbg::snapshot_reader reader{data};
+    jdbg::snapshot_view view;
+
+    REQUIRE(reader.at(refs[1].offset, view) ==
+            jdbg::snapshot_reader::status::ok);
+    CHECK(view.count == 2);
+    CHECK(reader.at(refs[1].offset + 4, view) ==
+          jdbg::snapshot_reader::status::corrupt);
+  }
+
+  SECTION("cut short")
+  {
+    jdbg::snapshot_reader reader{
+        std::string_view{data}.substr(0, refs[1].offset + 70)};
+    jdbg::snapshot_view view;
+
+    CHECK(reader.next(view));
+    CHECK_FALSE(reader.next(view));
+    CHECK(reader.state() == jdbg::snapshot_reader::status::truncated);
+  }
+
+  SECTION("not a snapshot file")
+  {
+    jdbg::snapshot_reader reader{"JDBGLZ1\n"};
+    jdbg::snapshot_view view;
+
+    CHECK_FALSE(reader.next(view));
+    CHECK(reader.state() == jdbg::snapshot_reader::status::corrupt);
+  }
+}
+
+TEST_CASE("snapshot ref printing")
+{
+  const jdbg::snapshot_ref ref{"a.snap", 128, "int", 4, 3, 0};
+
+  SECTION("text")
+  {
+    std::ostringstream os;
+    jdbg::pretty_print(os, ref);
+    CHECK(os.str() == "snapshot a.snap@128 (3 x int)");
+  }
+
+  SECTION("json")
+  {
+    std::string out;
+    jdbg::json_writer json{out};
+    jdbg::json_print(json, ref);
+    CHECK(out == R"({"file":"a.snap","offset":128,"element_type":"int",)"
+                 R"("element_size":4,"count":3})");
+  }
+
+  SECTION("error")
+  {
+    const jdbg::snapshot_ref failed{"/no/such/dir/a.snap", 0, "int", 4, 3,
+                                    ENOENT};
+    std::ostringstream os;
+    jdbg::pretty_print(os, failed);
+    CHECK_THAT(os.str(),
+               StartsWith("cannot snapshot to /no/such/dir/a.snap: "));
+  }
+}
@@ -0,0 +1,188 @@
+#include <jdbg/summary.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Straightforward version of what summarize() computes
+template <typename T>
+jdbg::numeric_summary<T> reference(const std::vector<T>& v)
+{
+  jdbg::numeric_summary<T> res;
+  res.size = v.size();
+  res.sorted = std::is_sorted(v.begin(), v.end());
+  bool first = true;
+  for (const auto x : v) {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (std::isnan(x)) {
+        ++res.nan;
+        continue;
+      }
+      res.inf += std::isinf(x) ? 1 : 0;
+    }
+    res.min = first ? x : std::min(res.min, x);
+    res.max = first ? x : std::max(res.max, x);
+    first = false;
+    res.sum += static_cast<double>(x);
+    res.zeros += x == 0 ? 1 : 0;
+  }
+  return res;
+}
+
+template <typename T>
+void check_against_reference(const std::vector<T>& v)
+{
+  const auto expected = reference(v);
+  const auto actual = jdbg::summarize(v);
+
+  CAPTURE(v.size());
+  CHECK(actual.size == expected.size);
+  CHECK(actual.nan == expected.nan);
+  CHECK(actual.inf == expected.inf);
+  CHECK(actual.zeros == expected.zeros);
+  CHECK(actual.sorted == expected.sorted);
+  if (expected.size > expected.nan) {
+    CHECK(actual.min == expected.min);
+    CHECK(actual.max == expected.max);
+  }
+  if (std::isfinite(expected.sum)) {
+    // Lanes add up in a different order than the reference
+    CHECK(std::abs(actual.sum - expected.sum) <=
+          1e-4 * std::max(1.0, std::abs(expected.sum)));
+  } else if (std::isnan(expected.sum)) {
+    CHECK(std::isnan(actual.sum));
+  } else {
+    CHECK(actual.sum == expected.sum);
+  }
+}
+
+template <typename T>
+std::vector<T> random_values(std::size_t size, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> dist{-100, 100};
+  std::uniform_int_distribution<int> special{0, 19};
+  std::vector<T> v(size);
+  for (auto& x : v) {
+    switch (special(rng)) {
+    case 0:
+      x = 0;
+      break;
+    case 1:
+      x = std::numeric_limits<T>::quiet_NaN();
+      break;
+    case 2:
+      x = (dist(rng) < 0 ? -1 : 1) * std::numeric_limits<T>::infinity();
+      break;
+    default:
+      x = static_cast<T>(dist(rng));
+      break;
+    }
+  }
+  return v;
+}
+
+template <typename T>
+std::string print(const jdbg::numeric_summary<T>& val)
+{
+  std::ostringstream os;
+  jdbg::pretty_print(os, val);
+  return os.str();
+}
+
+} // namespace
+
+TEST_CASE("summarize")
+{
+  std::mt19937 rng{42};
+
+  SECTION("matches a scalar reference at every tail length")
+  {
+    for (std::size_t size = 0; size < 80; ++size) {
+      check_against_reference(random_values<double>(size, rng));
+      check_against_reference(random_values<float>(size, rng));
+    }
+    check_against_reference(random_values<double>(100003, rng));
+    check_against_reference(random_values<float>(100003, rng));
+  }
+
+  SECTION("sortedness")
+  {
+    std::vector<double> v(1000);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      v[i] = static_cast<double>(i) / 4;
+    }
+    CHECK(jdbg::summarize(v).sorted);
+
+    // Out of order pairs inside a vector and straddling two vectors
+    for (const std::size_t at : {std::size_t{10}, std::size_t{15}}) {
+      auto copy = v;
+      std::swap(copy[at], copy[at + 1]);
+      CHECK_FALSE(jdbg::summarize(copy).sorted);
+    }
+
+    // NaNs never compare less, just like with std::is_sorted()
+    v[500] = std::numeric_limits<double>::quiet_NaN();
+    CHECK(jdbg::summarize(v).sorted);
+  }
+
+  SECTION("integers")
+  {
+    const std::vector<int> v{5, -3, 0, 12, 0, 7};
+    const auto s = jdbg::summarize(v);
+
+    CHECK(s.min == -3);
+    CHECK(s.max == 12);
+    CHECK(s.sum == 21);
+    CHECK(s.zeros == 2);
+    CHECK_FALSE(s.sorted);
+    CHECK(print(s) == "{size: 6, min: -3, max: 12, mean: 3.5, sum: 21, "
+                      "zeros: 2, sorted: false}");
+  }
+
+  SECTION("arrays")
+  {
+    const unsigned a[] = {1, 2, 3};
+    const std::array<float, 2> b{0.5F, 0.25F};
+
+    CHECK(print(jdbg::summarize(a)) ==
+          "{size: 3, min: 1, max: 3, mean: 2, sum: 6, zeros: 0, sorted: true}");
+    CHECK(print(jdbg::summarize(b)) ==
+          "{size: 2, min: 0.25, max: 0.5, mean: 0.375, sum: 0.75, nan: 0, "
+          "inf: 0, zeros: 0, sorted: false}");
+  }
+
+  SECTION("empty and all NaN")
+  {
+    CHECK(print(jdbg::summarize(std::vector<double>{})) == "{size: 0}");
+
+    const std::vector<double> nans(9, std::nan(""));
+    const auto s = jdbg::summarize(nans);
+    CHECK(std::isnan(s.min));
+    CHECK(std::isnan(s.mean()));
+    CHECK(s.nan == 9);
+  }
+
+  SECTION("json")
+  {
+    std::string buf;
+    jdbg::json_writer json{buf};
+    jdbg::json_print(json, jdbg::summarize(std::vector<int>{2, 4}));
+
+    CHECK(buf == "{\"size\":2,\"min\":2,\"max\":4,\"mean\":3,\"sum\":6,"
+                 "\"nan\":0,\"inf\":0,\"zeros\":0,\"sorted\":true}");
+  }
+}
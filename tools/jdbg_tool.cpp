@@ -0,0 +1,334 @@
+#include <jdbg/compressed_sink.hpp>
+#include <jdbg/detail/writer.hpp>
+#include <jdbg/shm_sink.hpp>
+#include <jdbg/snapshot.hpp>
+#include <jdbg/type_name.hpp> // NOLINT
+
+#include <algorithm>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Read-only view of a whole file, mapped when it is not empty
+class mapped_file {
+public:
+  explicit mapped_file(const char* path) : fd_{::open(path, O_RDONLY)}
+  {
+    struct stat st {};
+    if (fd_ < 0 || fstat(fd_, &st) != 0) {
+      return;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+      addr_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    }
+  }
+
+  ~mapped_file()
+  {
+    if (addr_ != MAP_FAILED && addr_ != nullptr) {
+      munmap(addr_, size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  bool is_open() const { return fd_ >= 0 && addr_ != MAP_FAILED; }
+
+  std::string_view data() const
+  {
+    if (addr_ == nullptr || addr_ == MAP_FAILED) {
+      return {};
+    }
+    return {static_cast<const char*>(addr_), size_};
+  }
+
+private:
+  int fd_;
+  std::size_t size_{0};
+  void* addr_{nullptr};
+};
+
+int usage()
+{
+  std::fputs("usage: jdbg-tool decompress <input> [<output>]\n"
+             "       jdbg-tool snapshot <file> [<offset>]\n"
+             "       jdbg-tool collect <name> [--once] [--json] "
+             "[--window <ms>]\n",
+             stderr);
+  return EXIT_FAILURE;
+}
+
+int decompress(const char* input, const char* output)
+{
+  const mapped_file in{input};
+  if (!in.is_open()) {
+    std::perror(input);
+    return EXIT_FAILURE;
+  }
+  std::FILE* out = output != nullptr ? std::fopen(output, "wb") : stdout;
+  if (out == nullptr) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+
+  jdbg::compressed_file_reader reader{in.data()};
+  std::string block;
+  while (reader.next(block)) {
+    std::fwrite(block.data(), 1, block.size(), out);
+  }
+  if (out != stdout) {
+    std::fclose(out);
+  }
+
+  using status = jdbg::compressed_file_reader::status;
+  switch (reader.state()) {
+  case status::truncated:
+    // Expected when the writer did not shut down cleanly
+    std::fprintf(stderr, "%s: truncated after the last complete block\n",
+                 input);
+    return EXIT_SUCCESS;
+  case status::corrupt:
+    std::fprintf(stderr, "%s: corrupt data\n", input);
+    return EXIT_FAILURE;
+  default:
+    return EXIT_SUCCESS;
+  }
+}
+
+// Prints the elements one per line if they are of type T, converted from
+// the byte order of the writer
+template <typename T>
+bool print_elements_as(const jdbg::snapshot_view& view)
+{
+  if (view.element_size != sizeof(T) || view.type != jdbg::get_type_name<T>()) {
+    return false;
+  }
+
+  const auto* data = static_cast<const char*>(view.data);
+  std::string line;
+  for (std::size_t i = 0; i < view.count; ++i) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, data + i * sizeof(T), sizeof(T));
+    if (!view.is_native()) {
+      std::reverse(raw, raw + sizeof(T));
+    }
+    T val;
+    std::memcpy(&val, raw, sizeof(T));
+
+    line.clear();
+    jdbg::detail::writer out{line};
+    if constexpr (std::is_same_v<T, bool>) {
+      out.write(val ? "true" : "false");
+    } else if constexpr (std::is_floating_point_v<T>) {
+      out.write_float(val);
+    } else if constexpr (std::is_signed_v<T>) {
+      out.write_integer(static_cast<long long>(val));
+    } else {
+      out.write_integer(static_cast<unsigned long long>(val));
+    }
+    out.put('\n');
+    std::fwrite(line.data(), 1, line.size(), stdout);
+  }
+  return true;
+}
+
+// Elements of any other type as hex bytes in file order
+void print_elements_hex(const jdbg::snapshot_view& view)
+{
+  constexpr char digits[] = "0123456789abcdef";
+  const auto* data = static_cast<const unsigned char*>(view.data);
+  std::string line;
+  for (std::size_t i = 0; i < view.count; ++i) {
+    line.clear();
+    for (std::size_t j = 0; j < view.element_size; ++j) {
+      const auto byte = data[i * view.element_size + j];
+      line += digits[byte >> 4];
+      line += digits[byte & 0xF];
+    }
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), stdout);
+  }
+}
+
+template <typename... Ts>
+void print_elements(const jdbg::snapshot_view& view)
+{
+  if (!(print_elements_as<Ts>(view) || ...)) {
+    print_elements_hex(view);
+  }
+}
+
+int print_status(const char* input, jdbg::snapshot_reader::status state)
+{
+  using status = jdbg::snapshot_reader::status;
+  switch (state) {
+  case status::truncated:
+    std::fprintf(stderr, "%s: truncated snapshot\n", input);
+    return EXIT_FAILURE;
+  case status::corrupt:
+    std::fprintf(stderr, "%s: corrupt data\n", input);
+    return EXIT_FAILURE;
+  default:
+    return EXIT_SUCCESS;
+  }
+}
+
+// Lists the snapshots in a file, or prints the elements of the one at
+// offset as text
+int snapshot(const char* input, const char* offset)
+{
+  const mapped_file in{input};
+  if (!in.is_open()) {
+    std::perror(input);
+    return EXIT_FAILURE;
+  }
+
+  jdbg::snapshot_reader reader{in.data()};
+  jdbg::snapshot_view view;
+  if (offset != nullptr) {
+    const auto state = reader.at(std::strtoull(offset, nullptr, 10), view);
+    if (state != jdbg::snapshot_reader::status::ok) {
+      return print_status(input, state);
+    }
+    print_elements<bool, char, signed char, unsigned char, short,
+                   unsigned short, int, unsigned int, long, unsigned long,
+                   long long, unsigned long long, float, double>(view);
+    return EXIT_SUCCESS;
+  }
+
+  while (reader.next(view)) {
+    std::printf("%llu: %zu x %.*s (%zu bytes, %s endian)\n",
+                static_cast<unsigned long long>(view.offset), view.count,
+                static_cast<int>(view.type.size()), view.type.data(),
+                view.element_size, view.little_endian ? "little" : "big");
+  }
+  return print_status(input, reader.state());
+}
+
+volatile std::sig_atomic_t stop_collecting = 0; // NOLINT
+
+void request_stop(int /*signal*/)
+{
+  stop_collecting = 1;
+}
+
+// "[pid] record", or with json {"pid":..,"time":..,"record":record} where
+// records that are not JSON objects become strings, and {.."note":".."} for
+// collector notes
+void print_record(const jdbg::shm_record& rec, bool json, std::string& line)
+{
+  line.clear();
+  jdbg::detail::writer out{line};
+  if (json) {
+    jdbg::json_writer writer{line};
+    jdbg::json_print(writer, rec);
+  } else {
+    out.put('[');
+    out.write_integer(rec.pid);
+    out.write("] ");
+    out.write(rec.text);
+  }
+  out.put('\n');
+  std::fwrite(line.data(), 1, line.size(), stdout);
+}
+
+// Drains the rings of a shm_sink segment until interrupted, or once, and
+// prints their records ordered by time. Records are held back for a window
+// so that slower processes can catch up before the ones after them print.
+int collect(int argc, char* argv[])
+{
+  const char* name = argv[2];
+  bool once = false;
+  bool json = false;
+  std::uint64_t window_ms = 100;
+  for (int i = 3; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    if (arg == "--once") {
+      once = true;
+    } else if (arg == "--json") {
+      json = true;
+    } else if (arg == "--window" && i + 1 < argc) {
+      window_ms = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      return usage();
+    }
+  }
+
+  jdbg::shm_collector collector{name};
+  if (!collector.is_open()) {
+    std::fprintf(stderr, "%s: %s\n", name, std::strerror(collector.error()));
+    return EXIT_FAILURE;
+  }
+
+  struct sigaction action {};
+  action.sa_handler = &request_stop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  std::vector<jdbg::shm_record> pending;
+  std::string line;
+  for (;;) {
+    const bool last = once || stop_collecting != 0;
+    const auto taken = collector.drain(pending);
+
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const auto& a, const auto& b) {
+                       return a.time < b.time;
+                     });
+    const auto now = jdbg::detail::shm::now();
+    const auto window = window_ms * 1000000;
+    const auto horizon = now > window ? now - window : 0;
+    auto it = pending.begin();
+    for (; it != pending.end() && (last || it->time <= horizon); ++it) {
+      print_record(*it, json, line);
+    }
+    pending.erase(pending.begin(), it);
+    std::fflush(stdout);
+
+    if (last) {
+      return EXIT_SUCCESS;
+    }
+    if (taken == 0) {
+      ::usleep(10000);
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    return usage();
+  }
+  const std::string_view command{argv[1]};
+  if (command == "decompress" && (argc == 3 || argc == 4)) {
+    return decompress(argv[2], argc == 4 ? argv[3] : nullptr);
+  }
+  if (command == "snapshot" && (argc == 3 || argc == 4)) {
+    return snapshot(argv[2], argc == 4 ? argv[3] : nullptr);
+  }
+  if (command == "collect" && argc >= 3) {
+    return collect(argc, argv);
+  }
+  return usage();
+}